@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "builtin/backend.hpp"
+#include "builtin/manager.hpp"
+#include "ipc/client.hpp"
+#include "ipc/daemon.hpp"
+#include "ipc/ring.hpp"
+
+// End-to-end latency of the trigger path: a forked client process calls TriggerClient::play, a real TriggerDaemon
+// drains the ring and dispatches through SoundManager, and a stub backend stamps the moment play() is reached.
+// Mixing and the audio device are not part of it, the figures stop where the backend would start a voice
+//
+// usage: soundhouse-ipc-bench [count] [interval-us]
+//
+// Intervals past the daemon's spin/yield/sleep window (a few tens of ms) show the parked case instead of the hot one
+
+namespace
+{
+    // How long the last triggers get to arrive once the client is gone, anything missing after that is a lost trigger
+    constexpr auto DRAIN_TIMEOUT = std::chrono::seconds(2);
+
+    /**
+     * @brief Backend that only records when each play() call arrives
+     *
+     */
+    class StampingBackend : public Soundhouse::Sounds::Backends::IAudioBackend
+    {
+        public:
+            explicit StampingBackend(std::size_t capacity) : Soundhouse::Sounds::Backends::IAudioBackend("StampingBackend"), m_stamps(capacity)
+            {
+            }
+
+            int load_sound(const std::string &path) override
+            {
+                return m_nextID++;
+            }
+
+            void unload_sound(int id) override
+            {
+            }
+
+            bool reload_sound(int id, const std::string &path) override
+            {
+                return true;
+            }
+
+            void play(int id) override
+            {
+                uint64_t    now   = Soundhouse::IPC::monotonic_nanos();
+                std::size_t index = m_arrived.load(std::memory_order_relaxed);
+
+                if (index < m_stamps.size())
+                {
+                    m_stamps[index] = now;
+                }
+
+                m_arrived.store(index + 1, std::memory_order_release);
+            }
+
+            void stop(int id) override
+            {
+            }
+
+            void set_volume(int id, float volume) override
+            {
+            }
+
+            float level(int id) override
+            {
+                return 0.0f;
+            }
+
+            bool any_playing() const override
+            {
+                return false;
+            }
+
+            std::size_t arrived() const
+            {
+                return m_arrived.load(std::memory_order_acquire);
+            }
+
+            const std::vector<uint64_t> &stamps() const
+            {
+                return m_stamps;
+            }
+
+        private:
+            std::vector<uint64_t>    m_stamps;
+            std::atomic<std::size_t> m_arrived{0};
+            int                      m_nextID = 0;
+    };
+
+    void print_percentile(const char *label, const std::vector<uint64_t> &sorted, double fraction)
+    {
+        std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(fraction * (sorted.size() - 1)));
+        std::printf("  %-6s %10.3f us\n", label, sorted[index] / 1e3);
+    }
+
+    void *map_shared(std::size_t bytes)
+    {
+        void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::runtime_error("failed to map shared memory for the stamps");
+        }
+
+        return memory;
+    }
+
+    // One client means one lane, so triggers reach the backend in the order they were sent and sentAt[i] matches the i-th play()
+    void run_client(const std::string &ringName, const std::string &socketPath, int sound, std::size_t count, uint64_t intervalNanos, const std::atomic<bool> &start, uint64_t *sentAt)
+    {
+        Soundhouse::IPC::TriggerClient client(ringName, socketPath);
+
+        while (!start.load(std::memory_order_acquire))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Busy wait rather than sleep where there's a core to spare, a sleeping sender would measure the scheduler instead of the ring
+        bool spin = std::thread::hardware_concurrency() > 1;
+
+        uint64_t next = Soundhouse::IPC::monotonic_nanos();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            for (uint64_t now; (now = Soundhouse::IPC::monotonic_nanos()) < next;)
+            {
+                if (!spin)
+                {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(next - now));
+                }
+            }
+
+            // Stamped before every attempt, so time spent waiting on a full lane isn't counted as transit
+            do
+            {
+                sentAt[i] = Soundhouse::IPC::monotonic_nanos();
+            } while (!client.play(sound));
+
+            next += intervalNanos;
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t count         = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    uint64_t    intervalNanos = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20) * 1000;
+
+    if (count == 0)
+    {
+        std::fprintf(stderr, "count has to be at least 1\n");
+        return 2;
+    }
+
+    Soundhouse::IPC::DaemonConfig config;
+    config.ringName   = "/soundhouse-bench-" + std::to_string(getpid());
+    config.socketPath = "/tmp/soundhouse-bench-" + std::to_string(getpid()) + ".sock";
+
+    try
+    {
+        auto  backend  = std::make_unique<StampingBackend>(count);
+        auto *stamping = backend.get();
+
+        Soundhouse::Sounds::SoundManager manager(std::move(backend));
+        Soundhouse::IPC::TriggerDaemon   daemon(manager, config);
+
+        int sound = manager.get_builtin(Soundhouse::Sounds::BuiltinSound::Fart).get_id();
+
+        auto *start  = new (map_shared(sizeof(std::atomic<bool>))) std::atomic<bool>(false);
+        auto *sentAt = static_cast<uint64_t *>(map_shared(count * sizeof(uint64_t)));
+
+        // Forked before the daemon starts its threads, so the child is a plain single threaded process
+        pid_t child = fork();
+        if (child < 0)
+        {
+            std::perror("fork");
+            return 1;
+        }
+
+        if (child == 0)
+        {
+            try
+            {
+                run_client(config.ringName, config.socketPath, sound, count, intervalNanos, *start, sentAt);
+            }
+            catch (const std::exception &error)
+            {
+                std::fprintf(stderr, "client: %s\n", error.what());
+                _exit(1);
+            }
+
+            _exit(0);
+        }
+
+        std::thread daemonThread([&daemon] { daemon.run(); });
+        start->store(true, std::memory_order_release);
+
+        int status = 0;
+        waitpid(child, &status, 0);
+
+        bool clientOK = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+        // Never give up on a trigger silently: either everything arrives or the run fails
+        auto deadline = std::chrono::steady_clock::now() + DRAIN_TIMEOUT;
+        while (clientOK && stamping->arrived() < count && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        daemon.stop();
+        daemonThread.join();
+
+        if (!clientOK)
+        {
+            std::fprintf(stderr, "soundhouse-ipc-bench: client failed\n");
+            return 1;
+        }
+
+        std::size_t arrived = stamping->arrived();
+        if (arrived != count)
+        {
+            std::fprintf(stderr, "soundhouse-ipc-bench: %zu of %zu triggers reached the backend\n", arrived, count);
+            return 1;
+        }
+
+        std::vector<uint64_t> latencies(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            latencies[i] = stamping->stamps()[i] - sentAt[i];
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        std::printf("%zu triggers, one every %llu us, TriggerClient::play -> backend play() latency:\n", count, static_cast<unsigned long long>(intervalNanos / 1000));
+        print_percentile("min", latencies, 0.0);
+        print_percentile("p50", latencies, 0.50);
+        print_percentile("p90", latencies, 0.90);
+        print_percentile("p99", latencies, 0.99);
+        print_percentile("p99.9", latencies, 0.999);
+        print_percentile("max", latencies, 1.0);
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "soundhouse-ipc-bench: %s\n", error.what());
+        return 1;
+    }
+
+    return 0;
+}
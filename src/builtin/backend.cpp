@@ -1,6 +1,10 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_audio.h>
 #include <SDL2/SDL_error.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
@@ -23,17 +27,207 @@ namespace Soundhouse::Sounds::Backends
         }
     }
 
+    namespace
+    {
+        // Frames per callback. A play request is only seen at the start of a block, and the size SDL_LoadWAV reports
+        // (4096) would make that up to ~90 ms at 44.1 kHz. 512 keeps it near 11 ms without starving slow devices
+        constexpr Uint16 CALLBACK_FRAMES = 512;
+
+        void release_voice(SoundData &sd)
+        {
+            if (sd.playing != nullptr)
+            {
+                sd.activeVoices->fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            sd.playing = nullptr;
+            sd.hazard.store(nullptr, std::memory_order_release);
+        }
+
+        // Peak of a block in the device's own format, scaled to 0..1. Formats we don't decode just read as full scale
+        float peak_of(const Uint8 *data, Uint32 bytes, SDL_AudioFormat format)
+        {
+            if (bytes == 0)
+            {
+                return 0.0f;
+            }
+
+            float peak = 0.0f;
+
+            switch (format)
+            {
+                case AUDIO_U8:
+                    for (Uint32 i = 0; i < bytes; i++)
+                    {
+                        peak = std::max(peak, std::abs(static_cast<int>(data[i]) - 128) / 128.0f);
+                    }
+                    return peak;
+
+                case AUDIO_S8:
+                    for (Uint32 i = 0; i < bytes; i++)
+                    {
+                        peak = std::max(peak, std::abs(static_cast<int>(static_cast<int8_t>(data[i]))) / 128.0f);
+                    }
+                    return peak;
+
+                case AUDIO_S16SYS:
+                    for (Uint32 i = 0; i + sizeof(int16_t) <= bytes; i += sizeof(int16_t))
+                    {
+                        int16_t sample;
+                        std::memcpy(&sample, data + i, sizeof(sample));
+                        peak = std::max(peak, std::abs(static_cast<int>(sample)) / 32768.0f);
+                    }
+                    return peak;
+
+                case AUDIO_S32SYS:
+                    for (Uint32 i = 0; i + sizeof(int32_t) <= bytes; i += sizeof(int32_t))
+                    {
+                        int32_t sample;
+                        std::memcpy(&sample, data + i, sizeof(sample));
+                        peak = std::max(peak, static_cast<float>(std::abs(static_cast<double>(sample)) / 2147483648.0));
+                    }
+                    return peak;
+
+                case AUDIO_F32SYS:
+                    for (Uint32 i = 0; i + sizeof(float) <= bytes; i += sizeof(float))
+                    {
+                        float sample;
+                        std::memcpy(&sample, data + i, sizeof(sample));
+                        peak = std::max(peak, std::fabs(sample));
+                    }
+                    return std::min(peak, 1.0f);
+
+                default:
+                    return 1.0f;
+            }
+        }
+
+        // Runs on SDL's audio thread. No locks and no allocation, the only shared state it reads is atomics
+        void SDLCALL audio_callback(void *userdata, Uint8 *stream, int length)
+        {
+            SoundData &sd     = *static_cast<SoundData *>(userdata);
+            Uint32     wanted = static_cast<Uint32>(length);
+
+            uint32_t play = sd.playRequests.load(std::memory_order_acquire);
+            uint32_t stop = sd.stopAt.load(std::memory_order_acquire);
+
+            if (play == stop)
+            {
+                release_voice(sd);
+            }
+            else if (play != sd.seenPlay)
+            {
+                // Publish the buffer before using it, then make sure it wasn't swapped out in between. Once the
+                // re-check passes, reclaim() is guaranteed to see our hazard and leave the buffer alone
+                SoundBuffer *buffer = sd.current.load(std::memory_order_acquire);
+                for (;;)
+                {
+                    sd.hazard.store(buffer, std::memory_order_seq_cst);
+
+                    SoundBuffer *latest = sd.current.load(std::memory_order_seq_cst);
+                    if (latest == buffer)
+                    {
+                        break;
+                    }
+
+                    buffer = latest;
+                }
+
+                if (sd.playing == nullptr)
+                {
+                    sd.activeVoices->fetch_add(1, std::memory_order_relaxed);
+                }
+
+                sd.playing  = buffer;
+                sd.position = 0;
+            }
+
+            sd.seenPlay = play;
+
+            Uint32 copied = 0;
+            if (sd.playing != nullptr)
+            {
+                Uint32 remaining = static_cast<Uint32>(sd.playing->samples.size()) - sd.position;
+
+                copied = remaining < wanted ? remaining : wanted;
+                std::memcpy(stream, sd.playing->samples.data() + sd.position, copied);
+                sd.position += copied;
+
+                if (sd.position >= sd.playing->samples.size())
+                {
+                    release_voice(sd);
+                }
+            }
+
+            sd.level.store(peak_of(stream, copied, sd.spec.format), std::memory_order_relaxed);
+
+            std::memset(stream + copied, sd.spec.silence, wanted - copied);
+        }
+    } // namespace
+
     SDL2Backend::~SDL2Backend()
     {
         for (auto &[id, sd] : m_sounds)
         {
-            SDL_CloseAudioDevice(sd.device);
-            SDL_FreeWAV(sd.buffer);
+            SDL_CloseAudioDevice(sd->device);
+            release(*sd);
         }
 
         SDL_Quit();
     }
 
+    bool SDL2Backend::decode(const std::string &path, const SDL_AudioSpec *target, SDL_AudioSpec &spec, SoundBuffer &buffer)
+    {
+        Uint8 *wav    = nullptr;
+        Uint32 length = 0;
+
+        if (SDL_LoadWAV(path.c_str(), &spec, &wav, &length) == nullptr)
+        {
+            logger.error("Failed to load WAV %s: %s", path.c_str(), SDL_GetError());
+            return false;
+        }
+
+        if (target == nullptr)
+        {
+            buffer.samples.assign(wav, wav + length);
+            SDL_FreeWAV(wav);
+            return true;
+        }
+
+        SDL_AudioCVT cvt;
+        int          needed = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, target->format, target->channels, target->freq);
+        if (needed < 0)
+        {
+            logger.error("Can't convert %s to the device format: %s", path.c_str(), SDL_GetError());
+            SDL_FreeWAV(wav);
+            return false;
+        }
+
+        buffer.samples.resize(static_cast<std::size_t>(length) * (needed ? cvt.len_mult : 1));
+        std::memcpy(buffer.samples.data(), wav, length);
+        SDL_FreeWAV(wav);
+
+        if (needed)
+        {
+            cvt.buf = buffer.samples.data();
+            cvt.len = static_cast<int>(length);
+
+            if (SDL_ConvertAudio(&cvt) != 0)
+            {
+                logger.error("Failed to convert %s: %s", path.c_str(), SDL_GetError());
+                return false;
+            }
+
+            buffer.samples.resize(static_cast<std::size_t>(cvt.len_cvt));
+        }
+        else
+        {
+            buffer.samples.resize(length);
+        }
+
+        return true;
+    }
+
     int SDL2Backend::load_sound(const std::string &path)
     {
         if (!std::filesystem::exists(path))
@@ -42,66 +236,197 @@ namespace Soundhouse::Sounds::Backends
             return -1;
         }
 
-        SoundData sd{};
-        if (SDL_LoadWAV(path.c_str(), &sd.spec, &sd.buffer, &sd.length) == nullptr)
+        SDL_AudioSpec wanted{};
+        auto          buffer = std::make_unique<SoundBuffer>();
+        if (!decode(path, nullptr, wanted, *buffer))
         {
-            logger.error("Failed to load WAV %s: %s", path.c_str(), SDL_GetError());
             return -1;
         }
 
-        SDL_AudioSpec obtained{};
-        sd.device = SDL_OpenAudioDevice(nullptr, 0, &sd.spec, &obtained, SDL_AUDIO_ALLOW_ANY_CHANGE);
-        if (sd.device == 0)
+        auto sd = std::make_unique<SoundData>();
+
+        wanted.samples   = CALLBACK_FRAMES;
+        wanted.callback  = audio_callback;
+        wanted.userdata  = sd.get();
+        sd->activeVoices = &m_activeVoices;
+
+        // The device may still pick its own format, but not a bigger block. SDL buffers for us if the hardware wants one
+        sd->device = SDL_OpenAudioDevice(nullptr, 0, &wanted, &sd->spec, SDL_AUDIO_ALLOW_ANY_CHANGE & ~SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+        if (sd->device == 0)
         {
             logger.error("Failed to open audio device: %s", SDL_GetError());
-            SDL_FreeWAV(sd.buffer);
             return -1;
         }
 
-        SDL_PauseAudioDevice(sd.device, 0);
+        // The device may have picked a different format, and the callback only copies bytes
+        if (sd->spec.format != wanted.format || sd->spec.channels != wanted.channels || sd->spec.freq != wanted.freq)
+        {
+            SDL_AudioSpec ignored{};
+            if (!decode(path, &sd->spec, ignored, *buffer))
+            {
+                SDL_CloseAudioDevice(sd->device);
+                return -1;
+            }
+        }
 
-        int id       = m_nextId++;
-        m_sounds[id] = sd;
-        logger.info("Loaded sound: %s (freq=%d, channels=%d, format=%d)", path.c_str(), sd.spec.freq, sd.spec.channels, sd.spec.format);
+        sd->current.store(buffer.release(), std::memory_order_release);
+
+        SDL_PauseAudioDevice(sd->device, 0);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        int id = m_nextId++;
+        logger.info("Loaded sound: %s (freq=%d, channels=%d, format=%d)", path.c_str(), sd->spec.freq, sd->spec.channels, sd->spec.format);
+        m_sounds[id] = std::move(sd);
         return id;
     }
 
     void SDL2Backend::unload_sound(int id)
     {
-        auto it = m_sounds.find(id);
-        if (it != m_sounds.end())
+        std::unique_ptr<SoundData> sd;
         {
-            SDL_ClearQueuedAudio(it->second.device);
-            SDL_CloseAudioDevice(it->second.device);
-            SDL_FreeWAV(it->second.buffer);
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_sounds.find(id);
+            if (it == m_sounds.end())
+            {
+                return;
+            }
+
+            sd = std::move(it->second);
             m_sounds.erase(it);
-            logger.info("Unloaded sound: %d", id);
         }
+
+        // Closing waits for a running callback to return, after that nobody can be reading the buffers. That can take a
+        // whole audio block, so it happens after the sound is out of the map and play() on other sounds isn't held up
+        SDL_CloseAudioDevice(sd->device);
+        release(*sd);
+        logger.info("Unloaded sound: %d", id);
+    }
+
+    bool SDL2Backend::reload_sound(int id, const std::string &path)
+    {
+        SDL_AudioSpec target{};
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_sounds.find(id);
+            if (it == m_sounds.end())
+            {
+                return false;
+            }
+
+            target = it->second->spec;
+        }
+
+        // The slow part happens without the lock, so play() on other sounds isn't held up
+        SDL_AudioSpec loaded{};
+        auto          buffer = std::make_unique<SoundBuffer>();
+        if (!decode(path, &target, loaded, *buffer))
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_sounds.find(id);
+        if (it == m_sounds.end())
+        {
+            return false;
+        }
+
+        SoundData &sd = *it->second;
+
+        SoundBuffer *previous = sd.current.exchange(buffer.release(), std::memory_order_seq_cst);
+        if (previous != nullptr)
+        {
+            sd.retired.push_back(previous);
+        }
+
+        reclaim(sd);
+
+        logger.info("Reloaded sound: %d from %s", id, path.c_str());
+        return true;
+    }
+
+    void SDL2Backend::reclaim(SoundData &sd)
+    {
+        SoundBuffer *inUse = sd.hazard.load(std::memory_order_seq_cst);
+
+        for (auto it = sd.retired.begin(); it != sd.retired.end();)
+        {
+            if (*it == inUse)
+            {
+                ++it;
+                continue;
+            }
+
+            delete *it;
+            it = sd.retired.erase(it);
+        }
+    }
+
+    void SDL2Backend::release(SoundData &sd)
+    {
+        // The device is closed by now, so a voice cut off mid-sound has to be taken off the count here
+        if (sd.playing != nullptr)
+        {
+            m_activeVoices.fetch_sub(1, std::memory_order_relaxed);
+            sd.playing = nullptr;
+        }
+
+        for (SoundBuffer *buffer : sd.retired)
+        {
+            delete buffer;
+        }
+
+        sd.retired.clear();
+        delete sd.current.exchange(nullptr);
     }
 
     void SDL2Backend::play(int id)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
         auto it = m_sounds.find(id);
         if (it != m_sounds.end())
         {
-            SDL_ClearQueuedAudio(it->second.device);
-            SDL_QueueAudio(it->second.device, it->second.buffer, it->second.length);
-            SDL_PauseAudioDevice(it->second.device, 0);
-            logger.info("Playing sound: %d", id);
+            // Retired buffers are only ever kept alive by a voice that was still playing, this is a good time to check on them
+            reclaim(*it->second);
+
+            it->second->playRequests.fetch_add(1, std::memory_order_release);
+
+            // Trace only: at Info every external trigger would cost a write() to the terminal
+            logger.trace("Playing sound: %d", id);
         }
     }
 
     void SDL2Backend::stop(int id)
     {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
         auto it = m_sounds.find(id);
         if (it != m_sounds.end())
         {
-            SDL_ClearQueuedAudio(it->second.device);
-            SDL_PauseAudioDevice(it->second.device, 1); // pause device
-            logger.info("Stopped sound: %d", id);
+            SoundData &sd = *it->second;
+            sd.stopAt.store(sd.playRequests.load(std::memory_order_relaxed), std::memory_order_release);
+            logger.trace("Stopped sound: %d", id);
         }
     }
 
+    float SDL2Backend::level(int id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_sounds.find(id);
+        return it != m_sounds.end() ? it->second->level.load(std::memory_order_relaxed) : 0.0f;
+    }
+
+    bool SDL2Backend::any_playing() const
+    {
+        return m_activeVoices.load(std::memory_order_relaxed) > 0;
+    }
+
     void SDL2Backend::set_volume(int id, float volume)
     {
         logger.warn("Not implemented yet");
@@ -1,5 +1,12 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <SDL2/SDL.h>
 
@@ -16,30 +23,61 @@ namespace Soundhouse::Sounds::Backends
         public:
             virtual ~IAudioBackend() = default;
 
-            virtual int  load_sound(const std::string &path) = 0;
-            virtual void unload_sound(int id)                = 0;
+            virtual int  load_sound(const std::string &path)           = 0;
+            virtual void unload_sound(int id)                          = 0;
+            virtual bool reload_sound(int id, const std::string &path) = 0;
 
             virtual void play(int id) = 0;
             virtual void stop(int id) = 0;
 
             virtual void set_volume(int id, float volume) = 0;
 
+            // Peak of the last audio block, 0 while silent. Meant to be polled by the UI
+            virtual float level(int id)       = 0;
+            virtual bool  any_playing() const = 0;
+
         protected:
             Logging::Logger logger;
 
             explicit IAudioBackend(const char *backendName);
     };
 
+    /**
+     * @brief Decoded samples, already converted to the format of the device that plays them
+     *
+     */
+    struct SoundBuffer
+    {
+        std::vector<Uint8> samples;
+    };
+
     /**
      * @brief Struct that carries output and the file's data
-     * 
+     *
+     * The buffer behind a sound can be swapped while it plays. The audio callback publishes the buffer it reads in
+     * hazard, and a retired buffer is only freed once hazard no longer points at it
      */
     struct SoundData
     {
-        SDL_AudioSpec spec;
-        Uint8* buffer = nullptr;
-        Uint32 length = 0;
+        SDL_AudioSpec     spec{}; // What the device actually plays
         SDL_AudioDeviceID device = 0;
+
+        std::atomic<SoundBuffer *> current{nullptr};
+        std::atomic<SoundBuffer *> hazard{nullptr};
+        std::vector<SoundBuffer *> retired;
+
+        // A play is pending while playRequests is ahead of what the callback has seen, stop() catches stopAt up to it
+        std::atomic<uint32_t> playRequests{0};
+        std::atomic<uint32_t> stopAt{0};
+
+        // Written by the audio callback once per block, so meters never need the callback to call out
+        std::atomic<float> level{0.0f};
+        std::atomic<int>  *activeVoices = nullptr;
+
+        // Only touched by the audio callback
+        SoundBuffer *playing  = nullptr;
+        Uint32       position = 0;
+        uint32_t     seenPlay = 0;
     };
 
     /**
@@ -55,13 +93,29 @@ namespace Soundhouse::Sounds::Backends
             int  load_sound(const std::string &path) override;
             void unload_sound(int id) override;
 
+            // Decodes on the calling thread, then swaps the new buffer in. Voices already playing finish on the old one
+            bool reload_sound(int id, const std::string &path) override;
+
             void play(int id) override;
             void stop(int id) override;
 
             void set_volume(int id, float volume) override;
 
+            float level(int id) override;
+            bool  any_playing() const override;
+
         private:
-            std::map<int, SoundData> m_sounds;
-            int                      m_nextId = 0;
+            bool decode(const std::string &path, const SDL_AudioSpec *target, SDL_AudioSpec &spec, SoundBuffer &buffer);
+
+            void reclaim(SoundData &sd);
+            void release(SoundData &sd);
+
+        private:
+            // Guards the map and retired lists, never taken by the audio callback
+            std::mutex                                 m_mutex;
+            std::map<int, std::unique_ptr<SoundData>> m_sounds;
+            int                                        m_nextId = 0;
+
+            std::atomic<int> m_activeVoices{0};
     };
 }; // namespace Soundhouse::Sounds::Backends
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <filesystem>
 #include <memory>
 #include <utility>
 
@@ -14,71 +16,258 @@ namespace Soundhouse::Sounds
 
     Sound SoundManager::load(const std::string &path)
     {
+        // Reading and decoding happen before the handle table is touched
         int backendID = backend->load_sound(path);
-        int handleID  = nextID++;
-
-        sounds[handleID] = path;
+        if (backendID < 0)
+        {
+            return Sound();
+        }
 
-        return Sound(handleID);
+        return register_sound(path, backendID, false);
     }
 
-    void SoundManager::unload(Sound sound)
+    bool SoundManager::unload(Sound sound)
     {
         if (!sound.is_valid() || sound.is_builtin())
         {
-            return;
+            return false;
         }
 
-        int id = sound.get_id();
-
-        auto iterator = sounds.find(id);
-        if (iterator != sounds.end())
+        LoadedSound loaded;
         {
-            backend->unload_sound(id);
+            std::unique_lock<std::shared_mutex> lock(soundsMutex);
+
+            auto iterator = sounds.find(sound.get_id());
+            if (iterator == sounds.end() || iterator->second.builtin)
+            {
+                return false;
+            }
+
+            loaded = std::move(iterator->second);
             sounds.erase(iterator);
         }
+
+        // The handle is gone already, so a trigger racing with this finds nothing instead of waiting for the device to close
+        untrack(loaded.path, loaded.backendID);
+        backend->unload_sound(loaded.backendID);
+        return true;
     }
 
     void SoundManager::play(Sound sound)
     {
-        if (sound.is_valid())
+        int id = backend_id(sound);
+        if (id >= 0)
         {
-            backend->play(sound.get_id());
+            backend->play(id);
         }
     }
 
     void SoundManager::stop(Sound sound)
     {
-        if (sound.is_valid())
+        int id = backend_id(sound);
+        if (id >= 0)
         {
-            backend->stop(sound.get_id());
+            backend->stop(id);
         }
     }
 
     void SoundManager::set_volume(Sound sound, float volume)
     {
-        if (sound.is_valid())
+        int id = backend_id(sound);
+        if (id >= 0)
+        {
+            backend->set_volume(id, volume);
+        }
+    }
+
+    float SoundManager::level(Sound sound) const
+    {
+        int id = backend_id(sound);
+        return id >= 0 ? backend->level(id) : 0.0f;
+    }
+
+    bool SoundManager::any_playing() const
+    {
+        return backend->any_playing();
+    }
+
+    bool SoundManager::reload(Sound sound)
+    {
+        if (!sound.is_valid())
+        {
+            return false;
+        }
+
+        LoadedSound loaded;
+        {
+            std::shared_lock<std::shared_mutex> lock(soundsMutex);
+
+            auto iterator = sounds.find(sound.get_id());
+            if (iterator == sounds.end())
+            {
+                return false;
+            }
+
+            loaded = iterator->second;
+        }
+
+        return backend->reload_sound(loaded.backendID, loaded.path);
+    }
+
+    void SoundManager::watch()
+    {
+        if (watcher)
         {
-            backend->set_volume(sound.get_id(), volume);
+            return;
         }
+
+        watcher = std::make_unique<Watching::FileWatcher>([this](Watching::WatchEvent event, const std::string &path) { on_file_changed(event, path); }, "SoundWatcher");
+
+        {
+            std::lock_guard<std::mutex> lock(watchMutex);
+            for (const auto &[path, ids] : watchedFiles)
+            {
+                watcher->watch_directory(std::filesystem::path(path).parent_path().string());
+            }
+        }
+
+        watcher->start();
     }
 
-    Sound SoundManager::create_builtin_sound(int id)
+    void SoundManager::stop_watching()
     {
-        return Sound(Sound::builtin_t{}, id);
+        watcher.reset();
+    }
+
+    void SoundManager::track(const std::string &path, int backendID)
+    {
+        std::string absolute = std::filesystem::absolute(path).lexically_normal().string();
+
+        std::lock_guard<std::mutex> lock(watchMutex);
+        watchedFiles[absolute].push_back(backendID);
+
+        if (watcher)
+        {
+            watcher->watch_directory(std::filesystem::path(absolute).parent_path().string());
+        }
+    }
+
+    void SoundManager::untrack(const std::string &path, int backendID)
+    {
+        std::string absolute = std::filesystem::absolute(path).lexically_normal().string();
+
+        std::lock_guard<std::mutex> lock(watchMutex);
+
+        auto iterator = watchedFiles.find(absolute);
+        if (iterator == watchedFiles.end())
+        {
+            return;
+        }
+
+        std::vector<int> &ids = iterator->second;
+        ids.erase(std::remove(ids.begin(), ids.end(), backendID), ids.end());
+
+        if (ids.empty())
+        {
+            watchedFiles.erase(iterator);
+        }
+    }
+
+    void SoundManager::on_file_changed(Watching::WatchEvent event, const std::string &path)
+    {
+        if (event != Watching::WatchEvent::Changed)
+        {
+            return;
+        }
+
+        std::vector<int> ids;
+        {
+            std::lock_guard<std::mutex> lock(watchMutex);
+
+            auto iterator = watchedFiles.find(path);
+            if (iterator == watchedFiles.end())
+            {
+                return;
+            }
+
+            ids = iterator->second;
+        }
+
+        // Runs on the watcher thread, so decoding never gets in the way of playback. The backend locks for the swap itself
+        for (int id : ids)
+        {
+            if (backend->reload_sound(id, path) && logger)
+            {
+                logger->info("Hot reloaded %s", path.c_str());
+            }
+        }
+    }
+
+    Sound SoundManager::create_builtin_sound(const std::string &path)
+    {
+        int backendID = backend->load_sound(path);
+        if (backendID < 0)
+        {
+            return Sound();
+        }
+
+        return register_sound(path, backendID, true);
+    }
+
+    Sound SoundManager::register_sound(const std::string &path, int backendID, bool builtin)
+    {
+        int handleID;
+        {
+            std::unique_lock<std::shared_mutex> lock(soundsMutex);
+
+            handleID         = nextID++;
+            sounds[handleID] = LoadedSound{path, backendID, builtin};
+        }
+
+        track(path, backendID);
+
+        return builtin ? Sound(Sound::builtin_t{}, handleID) : Sound(handleID);
+    }
+
+    int SoundManager::backend_id(Sound sound) const
+    {
+        if (!sound.is_valid())
+        {
+            return -1;
+        }
+
+        std::shared_lock<std::shared_mutex> lock(soundsMutex);
+
+        auto iterator = sounds.find(sound.get_id());
+        return iterator != sounds.end() ? iterator->second.backendID : -1;
     }
 
     void SoundManager::load_all_builtin_sounds()
     {
-        builtinSounds[BuiltinSound::Fart]      = create_builtin_sound(backend->load_sound("assets/fart.wav"));
-        builtinSounds[BuiltinSound::MenuClick] = create_builtin_sound(backend->load_sound("assets/menu_click.wav"));
-        builtinSounds[BuiltinSound::MenuHover] = create_builtin_sound(backend->load_sound("assets/menu_hover.wav"));
-        builtinSounds[BuiltinSound::ErrorBeep] = create_builtin_sound(backend->load_sound("assets/error_beep.wav"));
-        builtinSounds[BuiltinSound::ClownHorn] = create_builtin_sound(backend->load_sound("assets/clown_horn.wav"));
+        builtinSounds[BuiltinSound::Fart]      = create_builtin_sound("assets/fart.wav");
+        builtinSounds[BuiltinSound::MenuClick] = create_builtin_sound("assets/menu_click.wav");
+        builtinSounds[BuiltinSound::MenuHover] = create_builtin_sound("assets/menu_hover.wav");
+        builtinSounds[BuiltinSound::ErrorBeep] = create_builtin_sound("assets/error_beep.wav");
+        builtinSounds[BuiltinSound::ClownHorn] = create_builtin_sound("assets/clown_horn.wav");
     }
 
     Sound SoundManager::get_builtin(BuiltinSound which)
     {
         return builtinSounds[which];
     }
+
+    std::vector<std::pair<Sound, std::string>> SoundManager::list() const
+    {
+        std::shared_lock<std::shared_mutex> lock(soundsMutex);
+
+        std::vector<std::pair<Sound, std::string>> listing;
+        listing.reserve(sounds.size());
+
+        for (const auto &[id, loaded] : sounds)
+        {
+            listing.emplace_back(loaded.builtin ? Sound(Sound::builtin_t{}, id) : Sound(id), loaded.path);
+        }
+
+        return listing;
+    }
 } // namespace Soundhouse::Sounds
\ No newline at end of file
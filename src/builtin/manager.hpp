@@ -1,17 +1,38 @@
+#pragma once
+
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "builtin.hpp"
 #include "logger.hpp"
 #include "sound.hpp"
 #include "backend.hpp"
+#include "watcher.hpp"
 
 namespace Soundhouse::Sounds
 {
+    /**
+     * @brief What a handle points at in the backend
+     *
+     */
+    struct LoadedSound
+    {
+        std::string path;
+        int         backendID = -1;
+        bool        builtin   = false;
+    };
+
     /**
      * @brief SoundManager class. Every sound effect passes through here--builtin or not
      *
+     * Safe to use from several threads. The handle table has its own lock that is never held across backend calls, so a
+     * load that is busy reading a file doesn't keep play() on other threads waiting
      */
     class SoundManager
     {
@@ -20,28 +41,60 @@ namespace Soundhouse::Sounds
 
             Sound load(const std::string &path);
 
-            void unload(Sound sound);
+            // False for handles that aren't loaded and for builtins, which stay for the lifetime of the manager
+            bool unload(Sound sound);
 
             void play(Sound sound);
             void stop(Sound sound);
 
             void set_volume(Sound sound, float volume);
 
+            // Current peak of a sound, and whether anything is audible at all. Both are cheap enough to poll every frame
+            float level(Sound sound) const;
+            bool  any_playing() const;
+
+            // Re-reads the file behind a sound. The handle stays the same and anything already playing finishes on the old samples
+            bool reload(Sound sound);
+
+            // Reloads sounds by themselves whenever their file is saved
+            void watch();
+            void stop_watching();
+
             Sound get_builtin(BuiltinSound which);
 
+            std::vector<std::pair<Sound, std::string>> list() const;
+
         private:
-            Sound create_builtin_sound(int ID);
+            Sound create_builtin_sound(const std::string &path);
+
+            int   backend_id(Sound sound) const;
+            Sound register_sound(const std::string &path, int backendID, bool builtin);
+
+            void track(const std::string &path, int backendID);
+            void untrack(const std::string &path, int backendID);
+
+            void on_file_changed(Watching::WatchEvent event, const std::string &path);
 
             void load_all_builtin_sounds();
 
         private:
             std::unique_ptr<Backends::IAudioBackend> backend;
 
-            std::unordered_map<int, std::string>    sounds;
+            // Guards sounds and nextID. Lookups share it, only registering and removing a handle takes it exclusively
+            mutable std::shared_mutex soundsMutex;
+
+            std::unordered_map<int, LoadedSound>    sounds;
             std::unordered_map<BuiltinSound, Sound> builtinSounds;
 
             std::optional<Logging::Logger> logger;
 
             int nextID = 0;
+
+            // Absolute path -> backend ids, shared with the watcher thread
+            std::mutex                                        watchMutex;
+            std::unordered_map<std::string, std::vector<int>> watchedFiles;
+
+            // Declared after backend so it stops before the backend goes away
+            std::unique_ptr<Watching::FileWatcher> watcher;
     };
 } // namespace Soundhouse::Sounds
\ No newline at end of file
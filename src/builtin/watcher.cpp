@@ -0,0 +1,210 @@
+#include <filesystem>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "watcher.hpp"
+
+namespace Soundhouse::Watching
+{
+    FileWatcher::FileWatcher(WatchCallback callback, const char *name)
+        : m_callback(std::move(callback)), logger(name, Logging::LoggerLevel::Info, Logging::LoggerTimeResolution::Milliseconds)
+    {
+#ifdef __linux__
+        m_fd     = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (m_fd < 0 || m_wakeFd < 0)
+        {
+            logger.error("Failed to set up inotify, file watching is disabled");
+        }
+#else
+        logger.warn("File watching is only supported on Linux");
+#endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        stop();
+
+#ifdef __linux__
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+
+        if (m_wakeFd >= 0)
+        {
+            close(m_wakeFd);
+        }
+#endif
+    }
+
+    bool FileWatcher::watch_directory(const std::string &path)
+    {
+#ifdef __linux__
+        if (m_fd < 0)
+        {
+            return false;
+        }
+
+        int wd = inotify_add_watch(m_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR);
+        if (wd < 0)
+        {
+            logger.warn("Can't watch %s", path.c_str());
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_directories[wd] = path;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void FileWatcher::watch_tree(const std::string &root)
+    {
+        if (!watch_directory(root))
+        {
+            return;
+        }
+
+        std::error_code error;
+        for (auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, error); !error && it != std::filesystem::recursive_directory_iterator();
+             it.increment(error))
+        {
+            if (it->is_directory(error))
+            {
+                watch_directory(it->path().string());
+            }
+        }
+    }
+
+    void FileWatcher::start()
+    {
+#ifdef __linux__
+        if (m_fd < 0 || m_running.exchange(true))
+        {
+            return;
+        }
+
+        m_thread = std::thread(&FileWatcher::run, this);
+#endif
+    }
+
+    void FileWatcher::stop()
+    {
+#ifdef __linux__
+        if (!m_running.exchange(false))
+        {
+            return;
+        }
+
+        uint64_t one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0)
+        {
+            logger.warn("Failed to wake the watcher thread");
+        }
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+#endif
+    }
+
+    void FileWatcher::run()
+    {
+#ifdef __linux__
+        alignas(inotify_event) char buffer[16 * 1024];
+
+        pollfd fds[2] = {
+            {m_fd, POLLIN, 0},
+            {m_wakeFd, POLLIN, 0},
+        };
+
+        while (m_running.load())
+        {
+            if (poll(fds, 2, -1) < 0)
+            {
+                continue;
+            }
+
+            if (fds[1].revents & POLLIN)
+            {
+                break;
+            }
+
+            ssize_t length;
+            while ((length = read(m_fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *cursor = buffer; cursor < buffer + length;)
+                {
+                    auto *event = reinterpret_cast<inotify_event *>(cursor);
+                    dispatch(event->wd, event->mask, event->len > 0 ? event->name : nullptr);
+                    cursor += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+#endif
+    }
+
+    void FileWatcher::dispatch(int wd, uint32_t mask, const char *name)
+    {
+#ifdef __linux__
+        if (mask & IN_Q_OVERFLOW)
+        {
+            logger.warn("inotify queue overflowed");
+            m_callback(WatchEvent::Overflow, std::string());
+            return;
+        }
+
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_directories.find(wd);
+            if (it == m_directories.end())
+            {
+                return;
+            }
+
+            directory = it->second;
+
+            // The kernel drops the watch for us, we only have to forget about it
+            if (mask & (IN_DELETE_SELF | IN_IGNORED))
+            {
+                m_directories.erase(it);
+                return;
+            }
+        }
+
+        if (name == nullptr)
+        {
+            return;
+        }
+
+        std::string path = (std::filesystem::path(directory) / name).string();
+
+        if ((mask & IN_ISDIR) && (mask & (IN_CREATE | IN_MOVED_TO)))
+        {
+            watch_tree(path);
+            m_callback(WatchEvent::DirectoryCreated, path);
+        }
+        else if (mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            m_callback(WatchEvent::Removed, path);
+        }
+        else if (mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+        {
+            m_callback(WatchEvent::Changed, path);
+        }
+#endif
+    }
+} // namespace Soundhouse::Watching
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "logger.hpp"
+
+namespace Soundhouse::Watching
+{
+    /**
+     * @brief What happened to a watched path
+     *
+     */
+    enum class WatchEvent
+    {
+        Changed,          // A file was written and closed, or moved into a watched directory
+        Removed,          // A file or directory was deleted or moved out
+        DirectoryCreated, // Already being watched by the time the callback runs
+        Overflow          // The kernel queue overflowed, anything may have changed
+    };
+
+    using WatchCallback = std::function<void(WatchEvent event, const std::string &path)>;
+
+    /**
+     * @brief inotify based directory watcher. Callbacks run on the watcher's own thread. Only does anything on Linux
+     *
+     */
+    class FileWatcher
+    {
+        public:
+            explicit FileWatcher(WatchCallback callback, const char *name = "FileWatcher");
+            ~FileWatcher();
+
+            FileWatcher(const FileWatcher &)            = delete;
+            FileWatcher &operator=(const FileWatcher &) = delete;
+
+            bool watch_directory(const std::string &path);
+            void watch_tree(const std::string &root);
+
+            void start();
+            void stop();
+
+        private:
+            void run();
+            void dispatch(int wd, uint32_t mask, const char *name);
+
+        private:
+            WatchCallback   m_callback;
+            Logging::Logger logger;
+
+            int m_fd     = -1;
+            int m_wakeFd = -1;
+
+            std::mutex                           m_mutex;
+            std::unordered_map<int, std::string> m_directories;
+
+            std::thread       m_thread;
+            std::atomic<bool> m_running{false};
+    };
+} // namespace Soundhouse::Watching
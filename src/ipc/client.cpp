@@ -0,0 +1,263 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "client.hpp"
+
+namespace Soundhouse::IPC
+{
+    TriggerClient::TriggerClient(const std::string &ringName, std::string socketPath)
+        : m_ringName(ringName), m_ring(std::make_unique<TriggerRing>(ringName)), m_socketPath(std::move(socketPath))
+    {
+    }
+
+    TriggerClient::~TriggerClient()
+    {
+        if (m_socket >= 0)
+        {
+            close(m_socket);
+        }
+    }
+
+    bool TriggerClient::play(int sound)
+    {
+        return push(TriggerOp::Play, sound, 1.0f);
+    }
+
+    bool TriggerClient::stop(int sound)
+    {
+        return push(TriggerOp::Stop, sound, 1.0f);
+    }
+
+    bool TriggerClient::set_volume(int sound, float volume)
+    {
+        return push(TriggerOp::SetVolume, sound, volume);
+    }
+
+    bool TriggerClient::push(TriggerOp op, int sound, float volume)
+    {
+        TriggerCommand command;
+        command.op     = op;
+        command.sound  = sound;
+        command.volume = volume;
+        command.sentAt = monotonic_nanos();
+
+        if (m_ring->push(command))
+        {
+            return true;
+        }
+
+        if (!m_ring->closed())
+        {
+            m_lastError = "trigger ring is full";
+            return false;
+        }
+
+        // Only reached once per restart, the new ring is kept for every trigger after this one
+        if (!reconnect() || !m_ring->push(command))
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TriggerClient::reconnect()
+    {
+        try
+        {
+            m_ring = std::make_unique<TriggerRing>(m_ringName);
+        }
+        catch (const std::exception &error)
+        {
+            m_lastError = std::string("daemon shut down or restarted: ") + error.what();
+            return false;
+        }
+
+        // The old control connection went down with the old daemon
+        if (m_socket >= 0)
+        {
+            close(m_socket);
+            m_socket = -1;
+            m_buffer.clear();
+        }
+
+        return true;
+    }
+
+    int TriggerClient::load(const std::string &path)
+    {
+        if (path.find('\n') != std::string::npos)
+        {
+            m_lastError = "path contains a newline";
+            return -1;
+        }
+
+        std::string reply;
+        if (!request("LOAD " + path, reply))
+        {
+            return -1;
+        }
+
+        return std::atoi(reply.c_str());
+    }
+
+    bool TriggerClient::unload(int sound)
+    {
+        std::string reply;
+        return request("UNLOAD " + std::to_string(sound), reply);
+    }
+
+    bool TriggerClient::list(std::vector<SoundListing> &sounds)
+    {
+        std::string reply;
+        if (!request("LIST", reply))
+        {
+            return false;
+        }
+
+        int count = std::atoi(reply.c_str());
+        sounds.clear();
+
+        for (int i = 0; i < count; i++)
+        {
+            std::string line;
+            if (!read_line(line))
+            {
+                return false;
+            }
+
+            std::size_t tab = line.find('\t');
+
+            SoundListing listing;
+            listing.id   = std::atoi(line.c_str());
+            listing.path = tab == std::string::npos ? std::string() : line.substr(tab + 1);
+            sounds.push_back(std::move(listing));
+        }
+
+        return true;
+    }
+
+    const std::string &TriggerClient::last_error() const
+    {
+        return m_lastError;
+    }
+
+    bool TriggerClient::connect_control()
+    {
+        if (m_socket >= 0)
+        {
+            return true;
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (m_socketPath.size() >= sizeof(address.sun_path))
+        {
+            m_lastError = "socket path too long";
+            return false;
+        }
+
+        std::strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_socket < 0 || connect(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            m_lastError = "can't connect to " + m_socketPath + ": " + std::strerror(errno);
+
+            if (m_socket >= 0)
+            {
+                close(m_socket);
+                m_socket = -1;
+            }
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // Sends one request and leaves whatever follows "OK " in reply
+    bool TriggerClient::request(const std::string &line, std::string &reply)
+    {
+        if (!connect_control())
+        {
+            return false;
+        }
+
+        std::string message = line + "\n";
+
+        std::size_t written = 0;
+        while (written < message.size())
+        {
+            ssize_t count = send(m_socket, message.data() + written, message.size() - written, MSG_NOSIGNAL);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (count <= 0)
+            {
+                m_lastError = "lost connection to the daemon";
+                close(m_socket);
+                m_socket = -1;
+                return false;
+            }
+
+            written += static_cast<std::size_t>(count);
+        }
+
+        std::string answer;
+        if (!read_line(answer))
+        {
+            return false;
+        }
+
+        if (answer.compare(0, 2, "OK") != 0)
+        {
+            m_lastError = answer.compare(0, 4, "ERR ") == 0 ? answer.substr(4) : answer;
+            return false;
+        }
+
+        reply = answer.size() > 3 ? answer.substr(3) : std::string();
+        return true;
+    }
+
+    bool TriggerClient::read_line(std::string &line)
+    {
+        for (;;)
+        {
+            std::size_t newline = m_buffer.find('\n');
+            if (newline != std::string::npos)
+            {
+                line = m_buffer.substr(0, newline);
+                m_buffer.erase(0, newline + 1);
+                return true;
+            }
+
+            char    chunk[1024];
+            ssize_t count = recv(m_socket, chunk, sizeof(chunk), 0);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (count <= 0)
+            {
+                m_lastError = "lost connection to the daemon";
+                close(m_socket);
+                m_socket = -1;
+                m_buffer.clear();
+                return false;
+            }
+
+            m_buffer.append(chunk, static_cast<std::size_t>(count));
+        }
+    }
+} // namespace Soundhouse::IPC
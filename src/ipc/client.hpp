@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ring.hpp"
+
+namespace Soundhouse::IPC
+{
+    /**
+     * @brief A sound the daemon has loaded, as reported by LIST
+     *
+     */
+    struct SoundListing
+    {
+        int         id = -1;
+        std::string path;
+    };
+
+    /**
+     * @brief Client side of the trigger daemon. Triggers go straight into shared memory, control requests open the socket on first use
+     *
+     * Each client owns one lane of the ring, so triggers must come from one thread at a time. Give every thread its own client
+     */
+    class TriggerClient
+    {
+        public:
+            explicit TriggerClient(const std::string &ringName = DEFAULT_RING_NAME, std::string socketPath = default_socket_path());
+            ~TriggerClient();
+
+            TriggerClient(const TriggerClient &)            = delete;
+            TriggerClient &operator=(const TriggerClient &) = delete;
+
+            // No syscalls while the daemon is up. False when the ring is full, or when the daemon went away and isn't back.
+            // After a daemon restart the client maps the new ring by itself, but ids it got from LOAD belong to the old daemon
+            bool play(int sound);
+            bool stop(int sound);
+
+            // Delivered to the backend, but SDL2Backend doesn't apply volume yet
+            bool set_volume(int sound, float volume);
+
+            // Returns the new sound id, or -1 on failure
+            int  load(const std::string &path);
+            bool unload(int sound);
+            bool list(std::vector<SoundListing> &sounds);
+
+            const std::string &last_error() const;
+
+        private:
+            bool push(TriggerOp op, int sound, float volume);
+            bool reconnect();
+
+            bool connect_control();
+            bool request(const std::string &line, std::string &reply);
+            bool read_line(std::string &line);
+
+        private:
+            std::string                  m_ringName;
+            std::unique_ptr<TriggerRing> m_ring;
+
+            std::string m_socketPath;
+            int         m_socket = -1;
+            std::string m_buffer;
+            std::string m_lastError;
+    };
+} // namespace Soundhouse::IPC
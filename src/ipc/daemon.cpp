@@ -0,0 +1,342 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "daemon.hpp"
+
+namespace Soundhouse::IPC
+{
+    namespace
+    {
+        constexpr std::size_t MAX_REQUEST_LENGTH = 4096;
+
+        // Replies a client hasn't read yet. Past this it is treated as stuck and dropped
+        constexpr std::size_t MAX_PENDING_REPLY = 1 << 20;
+
+        /**
+         * @brief One accepted control socket. The socket is non-blocking, replies wait in output until it can take them
+         *
+         */
+        struct ControlConnection
+        {
+            std::string input;
+            std::string output;
+
+            // Set after a fatal error reply, the connection closes once that reply is out
+            bool closing = false;
+        };
+
+        // Sends as much as the socket takes right now. False when the peer is gone
+        bool flush(int fd, ControlConnection &connection)
+        {
+            while (!connection.output.empty())
+            {
+                ssize_t count = send(fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    return true;
+                }
+
+                if (count <= 0)
+                {
+                    return false;
+                }
+
+                connection.output.erase(0, static_cast<std::size_t>(count));
+            }
+
+            return true;
+        }
+
+        bool parse_id(const std::string &text, int &id)
+        {
+            char *end = nullptr;
+            long  value = std::strtol(text.c_str(), &end, 10);
+
+            if (text.empty() || *end != '\0' || value < 0 || value > INT32_MAX)
+            {
+                return false;
+            }
+
+            id = static_cast<int>(value);
+            return true;
+        }
+    } // namespace
+
+    TriggerDaemon::TriggerDaemon(Sounds::SoundManager &manager, DaemonConfig config)
+        : m_manager(manager), m_config(std::move(config)), logger("TriggerDaemon", Logging::LoggerLevel::Info, Logging::LoggerTimeResolution::Milliseconds),
+          m_ring(TriggerRing::create_t{}, m_config.ringName)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (m_config.socketPath.size() >= sizeof(address.sun_path))
+        {
+            logger.critical("Socket path %s is too long", m_config.socketPath.c_str());
+            throw std::runtime_error("socket path too long");
+        }
+
+        std::strncpy(address.sun_path, m_config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        m_wakeFd   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (m_listenFd < 0 || m_wakeFd < 0)
+        {
+            logger.critical("Failed to create control socket: %s", std::strerror(errno));
+            throw std::runtime_error("socket failed");
+        }
+
+        unlink(m_config.socketPath.c_str());
+
+        // Same user only, just like the 0600 shared memory ring
+        mode_t previousMask = umask(0077);
+        int    bound        = bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        umask(previousMask);
+
+        if (bound != 0 || listen(m_listenFd, 8) != 0)
+        {
+            logger.critical("Failed to listen on %s: %s", m_config.socketPath.c_str(), std::strerror(errno));
+            close(m_listenFd);
+            close(m_wakeFd);
+            throw std::runtime_error("bind/listen failed");
+        }
+
+        logger.info("Listening for triggers on %s and requests on %s", m_config.ringName.c_str(), m_config.socketPath.c_str());
+    }
+
+    TriggerDaemon::~TriggerDaemon()
+    {
+        stop();
+
+        if (m_controlThread.joinable())
+        {
+            m_controlThread.join();
+        }
+
+        close(m_listenFd);
+        close(m_wakeFd);
+        unlink(m_config.socketPath.c_str());
+    }
+
+    void TriggerDaemon::run()
+    {
+        m_running.store(true);
+        m_controlThread = std::thread(&TriggerDaemon::serve_control, this);
+
+        IdleBackoff    backoff(m_config.idleSleepMicros);
+        TriggerCommand command;
+
+        while (m_running.load(std::memory_order_relaxed))
+        {
+            if (!m_ring.pop(command))
+            {
+                backoff.wait(m_ring, m_running);
+                continue;
+            }
+
+            backoff.reset();
+            dispatch(command);
+        }
+
+        if (m_controlThread.joinable())
+        {
+            m_controlThread.join();
+        }
+    }
+
+    void TriggerDaemon::stop()
+    {
+        m_running.store(false);
+
+        // If this fails the counter is already non-zero, which wakes the control thread just the same
+        uint64_t one = 1;
+
+        [[maybe_unused]] ssize_t woken = write(m_wakeFd, &one, sizeof(one));
+
+        m_ring.ring_doorbell();
+    }
+
+    void TriggerDaemon::dispatch(const TriggerCommand &command)
+    {
+        // SoundManager locks its own handle table, and only for the lookup. A LOAD reading a file never holds it
+        Sounds::Sound sound(command.sound);
+
+        switch (command.op)
+        {
+            case TriggerOp::Play:
+                m_manager.play(sound);
+                break;
+            case TriggerOp::Stop:
+                m_manager.stop(sound);
+                break;
+            case TriggerOp::SetVolume:
+                m_manager.set_volume(sound, command.volume);
+                break;
+        }
+
+        logger.trace("Trigger %d reached the mixer after %llu ns", command.sound, static_cast<unsigned long long>(monotonic_nanos() - command.sentAt));
+    }
+
+    void TriggerDaemon::serve_control()
+    {
+        std::vector<pollfd>                        fds;
+        std::unordered_map<int, ControlConnection> connections;
+
+        while (m_running.load())
+        {
+            fds.clear();
+            fds.push_back({m_wakeFd, POLLIN, 0});
+            fds.push_back({m_listenFd, POLLIN, 0});
+
+            // A client that isn't reading its replies gets no new requests served until it catches up
+            for (const auto &[fd, connection] : connections)
+            {
+                fds.push_back({fd, static_cast<short>(connection.output.empty() ? POLLIN : POLLOUT), 0});
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                continue;
+            }
+
+            if (fds[0].revents & POLLIN)
+            {
+                break;
+            }
+
+            if (fds[1].revents & POLLIN)
+            {
+                int client = accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                if (client >= 0)
+                {
+                    connections[client];
+                }
+            }
+
+            for (std::size_t i = 2; i < fds.size(); i++)
+            {
+                if (fds[i].revents == 0)
+                {
+                    continue;
+                }
+
+                int                fd         = fds[i].fd;
+                ControlConnection &connection = connections[fd];
+
+                bool open = (fds[i].revents & (POLLERR | POLLNVAL)) == 0;
+
+                if (open && (fds[i].revents & (POLLIN | POLLHUP)) && connection.output.empty())
+                {
+                    char    chunk[1024];
+                    ssize_t count = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+
+                    open = count > 0 || (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+                    if (count > 0)
+                    {
+                        connection.input.append(chunk, static_cast<std::size_t>(count));
+
+                        std::size_t newline;
+                        while ((newline = connection.input.find('\n')) != std::string::npos)
+                        {
+                            std::string line = connection.input.substr(0, newline);
+                            connection.input.erase(0, newline + 1);
+
+                            connection.output += handle_request(line);
+                        }
+
+                        if (connection.input.size() > MAX_REQUEST_LENGTH)
+                        {
+                            connection.output += "ERR request too long\n";
+                            connection.input.clear();
+                            connection.closing = true;
+                        }
+                    }
+                }
+
+                open = open && flush(fd, connection) && connection.output.size() <= MAX_PENDING_REPLY;
+
+                if (!open || (connection.closing && connection.output.empty()))
+                {
+                    close(fd);
+                    connections.erase(fd);
+                }
+            }
+        }
+
+        for (const auto &[fd, connection] : connections)
+        {
+            close(fd);
+        }
+    }
+
+    std::string TriggerDaemon::handle_request(const std::string &line)
+    {
+        std::size_t space    = line.find(' ');
+        std::string verb     = line.substr(0, space);
+        std::string argument = space == std::string::npos ? std::string() : line.substr(space + 1);
+
+        if (verb == "LOAD")
+        {
+            if (argument.empty())
+            {
+                return "ERR missing path\n";
+            }
+
+            Sounds::Sound sound = m_manager.load(argument);
+            if (!sound.is_valid())
+            {
+                return "ERR failed to load " + argument + "\n";
+            }
+
+            return "OK " + std::to_string(sound.get_id()) + "\n";
+        }
+
+        if (verb == "UNLOAD")
+        {
+            int id;
+            if (!parse_id(argument, id))
+            {
+                return "ERR bad id\n";
+            }
+
+            // Builtins count as unknown here, they can't be unloaded
+            if (!m_manager.unload(Sounds::Sound(id)))
+            {
+                return "ERR unknown id\n";
+            }
+
+            return "OK\n";
+        }
+
+        if (verb == "LIST")
+        {
+            std::vector<std::pair<Sounds::Sound, std::string>> sounds = m_manager.list();
+
+            std::string reply = "OK " + std::to_string(sounds.size()) + "\n";
+            for (const auto &[sound, path] : sounds)
+            {
+                reply += std::to_string(sound.get_id()) + "\t" + path + "\n";
+            }
+
+            return reply;
+        }
+
+        return "ERR unknown request\n";
+    }
+} // namespace Soundhouse::IPC
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "builtin/logger.hpp"
+#include "builtin/manager.hpp"
+#include "ring.hpp"
+
+namespace Soundhouse::IPC
+{
+    /**
+     * @brief Where the daemon listens, and how long the trigger loop naps between polls before it parks on the ring
+     *
+     */
+    struct DaemonConfig
+    {
+        std::string ringName   = DEFAULT_RING_NAME;
+        std::string socketPath = default_socket_path();
+
+        uint32_t idleSleepMicros = 100;
+    };
+
+    /**
+     * @brief Serves external controllers: triggers through the shared-memory ring, load/unload/list through a Unix socket
+     *
+     * Control socket protocol, one request per line:
+     *   LOAD <path>   -> OK <id>
+     *   UNLOAD <id>   -> OK, or ERR unknown id for ids that aren't loaded and builtins
+     *   LIST          -> OK <count>, then one "<id>\t<path>" line per sound
+     * Failures answer ERR <reason>
+     */
+    class TriggerDaemon
+    {
+        public:
+            explicit TriggerDaemon(Sounds::SoundManager &manager, DaemonConfig config = {});
+            ~TriggerDaemon();
+
+            TriggerDaemon(const TriggerDaemon &)            = delete;
+            TriggerDaemon &operator=(const TriggerDaemon &) = delete;
+
+            // Drains the trigger ring on the calling thread until stop()
+            void run();
+
+            // Async-signal-safe, so it can be called straight from a SIGINT handler
+            void stop();
+
+        private:
+            void dispatch(const TriggerCommand &command);
+
+            void serve_control();
+            std::string handle_request(const std::string &line);
+
+        private:
+            Sounds::SoundManager &m_manager;
+            DaemonConfig          m_config;
+            Logging::Logger       logger;
+
+            TriggerRing m_ring;
+
+            int m_listenFd = -1;
+            int m_wakeFd   = -1;
+
+            std::thread       m_controlThread;
+            std::atomic<bool> m_running{false};
+    };
+} // namespace Soundhouse::IPC
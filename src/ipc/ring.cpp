@@ -0,0 +1,407 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "ring.hpp"
+
+namespace Soundhouse::IPC
+{
+    namespace
+    {
+        constexpr uint32_t RING_MAGIC    = 0x53485452; // "SHTR"
+        constexpr uint32_t RING_VERSION  = 3;
+        constexpr uint32_t LANE_COUNT    = 64;
+        constexpr uint64_t LANE_CAPACITY = 256;
+
+        static_assert((LANE_CAPACITY & (LANE_CAPACITY - 1)) == 0, "lane capacity has to be a power of two");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring relies on address-free 64-bit atomics");
+        static_assert(std::atomic<int32_t>::is_always_lock_free, "the ring relies on address-free 32-bit atomics");
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the doorbell is used as a futex word");
+
+        bool process_gone(int32_t pid)
+        {
+            return kill(pid, 0) != 0 && errno == ESRCH;
+        }
+
+        // The ring is shared between processes, so these are the non-private futex operations
+        void futex_wait(std::atomic<uint32_t> &word, uint32_t expected)
+        {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+#else
+            // No futex to block on, so poll the doorbell at a rate that costs next to nothing
+            if (word.load(std::memory_order_acquire) == expected)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+#endif
+        }
+
+        void futex_wake(std::atomic<uint32_t> &word)
+        {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+            (void)word;
+#endif
+        }
+
+        inline void cpu_relax()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+    } // namespace
+
+    // Single-producer ring. head is only written by the owning client and tail only by the daemon, so a push is one
+    // release store and nothing can be left half-claimed. Ownership passes on without a reset: a new owner just
+    // continues from head, overwriting whatever a dead owner may have left unpublished
+    struct Lane
+    {
+        std::atomic<int32_t> owner; // pid of the client writing this lane, 0 when free
+
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+
+        alignas(64) TriggerCommand slots[LANE_CAPACITY];
+    };
+
+    struct RingMemory
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t              version;
+
+        // Set once the daemon that created the ring is gone, clients holding the mapping then stop pushing into it
+        std::atomic<uint32_t> closed;
+
+        // parked is set by the daemon before it sleeps on doorbell, clients only ring when they see it
+        alignas(64) std::atomic<uint32_t> parked;
+        std::atomic<uint32_t>             doorbell;
+
+        Lane lanes[LANE_COUNT];
+    };
+
+    std::string default_socket_path()
+    {
+        const char *runtime = std::getenv("XDG_RUNTIME_DIR");
+        return std::string(runtime != nullptr && *runtime != '\0' ? runtime : "/tmp") + "/soundhouse.sock";
+    }
+
+    uint64_t monotonic_nanos()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    TriggerRing::TriggerRing(const std::string &name) : m_name(name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error("trigger ring " + name + " does not exist, is the daemon running?");
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) != sizeof(RingMemory))
+        {
+            close(fd);
+            throw std::runtime_error("trigger ring " + name + " has an unexpected size");
+        }
+
+        void *memory = mmap(nullptr, sizeof(RingMemory), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            throw std::runtime_error("failed to map trigger ring " + name);
+        }
+
+        m_memory = static_cast<RingMemory *>(memory);
+
+        if (m_memory->magic.load(std::memory_order_acquire) != RING_MAGIC || m_memory->version != RING_VERSION)
+        {
+            munmap(m_memory, sizeof(RingMemory));
+            throw std::runtime_error("trigger ring " + name + " is not ready or has the wrong version");
+        }
+
+        if (!claim_lane())
+        {
+            munmap(m_memory, sizeof(RingMemory));
+            throw std::runtime_error("all " + std::to_string(LANE_COUNT) + " trigger lanes are in use");
+        }
+    }
+
+    TriggerRing::TriggerRing(create_t, const std::string &name) : m_name(name), m_owner(true)
+    {
+        // A crashed daemon leaves its ring behind. Close it before unlinking, so clients still holding the old mapping
+        // find out instead of pushing into a ring nobody drains
+        close_stale(name);
+        shm_unlink(name.c_str());
+
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("failed to create trigger ring " + name);
+        }
+
+        if (ftruncate(fd, sizeof(RingMemory)) != 0)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("failed to size trigger ring " + name);
+        }
+
+        void *memory = mmap(nullptr, sizeof(RingMemory), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            throw std::runtime_error("failed to map trigger ring " + name);
+        }
+
+        m_memory          = new (memory) RingMemory;
+        m_memory->version = RING_VERSION;
+        m_memory->closed.store(0, std::memory_order_relaxed);
+        m_memory->parked.store(0, std::memory_order_relaxed);
+        m_memory->doorbell.store(0, std::memory_order_relaxed);
+
+        for (Lane &lane : m_memory->lanes)
+        {
+            lane.owner.store(0, std::memory_order_relaxed);
+            lane.head.store(0, std::memory_order_relaxed);
+            lane.tail.store(0, std::memory_order_relaxed);
+        }
+
+        // Clients check the magic before anything else, so it goes last
+        m_memory->magic.store(RING_MAGIC, std::memory_order_release);
+    }
+
+    TriggerRing::~TriggerRing()
+    {
+        // Anything still queued in the lane is delivered, whoever claims it next simply carries on after it
+        if (m_lane >= 0)
+        {
+            m_memory->lanes[m_lane].owner.store(0, std::memory_order_release);
+        }
+
+        if (m_owner)
+        {
+            m_memory->closed.store(1, std::memory_order_release);
+            shm_unlink(m_name.c_str());
+        }
+
+        if (m_memory != nullptr)
+        {
+            munmap(m_memory, sizeof(RingMemory));
+        }
+    }
+
+    void TriggerRing::close_stale(const std::string &name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) != sizeof(RingMemory))
+        {
+            close(fd);
+            return;
+        }
+
+        void *memory = mmap(nullptr, sizeof(RingMemory), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            return;
+        }
+
+        // Rings of another layout can't be closed, their clients were already turned away by the version check
+        RingMemory *stale = static_cast<RingMemory *>(memory);
+        if (stale->magic.load(std::memory_order_acquire) == RING_MAGIC && stale->version == RING_VERSION)
+        {
+            stale->closed.store(1, std::memory_order_release);
+        }
+
+        munmap(memory, sizeof(RingMemory));
+    }
+
+    bool TriggerRing::claim_lane()
+    {
+        const int32_t self = static_cast<int32_t>(getpid());
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (uint32_t i = 0; i < LANE_COUNT; i++)
+            {
+                Lane   &lane  = m_memory->lanes[i];
+                int32_t owner = lane.owner.load(std::memory_order_relaxed);
+
+                // Free lanes first, lanes of clients that died without letting go only when there are none left
+                bool claimable = pass == 0 ? owner == 0 : owner != 0 && process_gone(owner);
+                if (claimable && lane.owner.compare_exchange_strong(owner, self, std::memory_order_acquire))
+                {
+                    m_lane = static_cast<int>(i);
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool TriggerRing::push(const TriggerCommand &command)
+    {
+        if (closed())
+        {
+            return false;
+        }
+
+        Lane &lane = m_memory->lanes[m_lane];
+
+        uint64_t head = lane.head.load(std::memory_order_relaxed);
+        if (head - lane.tail.load(std::memory_order_acquire) >= LANE_CAPACITY)
+        {
+            return false;
+        }
+
+        lane.slots[head & (LANE_CAPACITY - 1)] = command;
+        lane.head.store(head + 1, std::memory_order_release);
+
+        // Pairs with the fence in park(): either the daemon sees the new head, or we see it parked and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_memory->parked.load(std::memory_order_relaxed) != 0)
+        {
+            ring_doorbell();
+        }
+
+        return true;
+    }
+
+    bool TriggerRing::closed() const
+    {
+        return m_memory->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    bool TriggerRing::pop(TriggerCommand &command)
+    {
+        for (uint32_t n = 0; n < LANE_COUNT; n++)
+        {
+            uint32_t index = (m_nextLane + n) % LANE_COUNT;
+            Lane    &lane  = m_memory->lanes[index];
+
+            uint64_t tail = lane.tail.load(std::memory_order_relaxed);
+            if (lane.head.load(std::memory_order_acquire) == tail)
+            {
+                continue;
+            }
+
+            command = lane.slots[tail & (LANE_CAPACITY - 1)];
+            lane.tail.store(tail + 1, std::memory_order_release);
+
+            // Start after this lane next time, so one chatty client can't starve the others
+            m_nextLane = (index + 1) % LANE_COUNT;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool TriggerRing::any_pending() const
+    {
+        for (const Lane &lane : m_memory->lanes)
+        {
+            if (lane.head.load(std::memory_order_relaxed) != lane.tail.load(std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void TriggerRing::park(const std::atomic<bool> &running)
+    {
+        // Taken before anything is checked, so a ring in between makes the futex wait return at once
+        uint32_t ticket = m_memory->doorbell.load(std::memory_order_acquire);
+
+        m_memory->parked.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (running.load(std::memory_order_relaxed) && !any_pending())
+        {
+            futex_wait(m_memory->doorbell, ticket);
+        }
+
+        m_memory->parked.store(0, std::memory_order_relaxed);
+    }
+
+    void TriggerRing::ring_doorbell()
+    {
+        m_memory->doorbell.fetch_add(1, std::memory_order_release);
+        futex_wake(m_memory->doorbell);
+    }
+
+    // Spinning on a single core only keeps the producer we're waiting for off the CPU
+    IdleBackoff::IdleBackoff(uint32_t sleepMicros) : m_sleepMicros(sleepMicros), m_firstRound(std::thread::hardware_concurrency() > 1 ? 0 : SPIN_ROUNDS)
+    {
+        m_idleRounds = m_firstRound;
+    }
+
+    void IdleBackoff::reset()
+    {
+        m_idleRounds = m_firstRound;
+    }
+
+    void IdleBackoff::wait(TriggerRing &ring, const std::atomic<bool> &running)
+    {
+        if (m_idleRounds < SPIN_ROUNDS)
+        {
+            m_idleRounds++;
+            cpu_relax();
+        }
+        else if (m_idleRounds < YIELD_ROUNDS)
+        {
+            m_idleRounds++;
+            std::this_thread::yield();
+        }
+        else if (m_idleRounds < SLEEP_ROUNDS)
+        {
+            m_idleRounds++;
+            std::this_thread::sleep_for(std::chrono::microseconds(m_sleepMicros));
+        }
+        else
+        {
+            ring.park(running);
+        }
+    }
+} // namespace Soundhouse::IPC
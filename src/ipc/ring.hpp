@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Soundhouse::IPC
+{
+    constexpr const char *DEFAULT_RING_NAME = "/soundhouse-triggers";
+
+    // $XDG_RUNTIME_DIR/soundhouse.sock, or /tmp/soundhouse.sock when that isn't set
+    std::string default_socket_path();
+
+    // CLOCK_MONOTONIC in nanoseconds. The clock is system wide, so stamps can be compared across processes
+    uint64_t monotonic_nanos();
+
+    enum class TriggerOp : uint32_t
+    {
+        Play,
+        Stop,
+        SetVolume
+    };
+
+    /**
+     * @brief One entry of the trigger ring. Sound ids are SoundManager handles
+     *
+     */
+    struct TriggerCommand
+    {
+        TriggerOp op     = TriggerOp::Play;
+        int32_t   sound  = -1;
+        float     volume = 1.0f;
+        uint64_t  sentAt = 0;
+    };
+
+    struct RingMemory;
+
+    /**
+     * @brief Lock-free trigger queue living in POSIX shared memory
+     *
+     * Every client claims its own single-producer lane, and the daemon round-robins over all of them. A client that dies
+     * halfway through a push can only ever strand its own lane, which the next client to connect takes over once the
+     * owner is gone. While the daemon is busy neither side makes a syscall. Once it has been idle for a while it parks on a
+     * futex, and only then does a push pay for a wake up
+     */
+    class TriggerRing
+    {
+        public:
+            struct create_t
+            {
+            };
+
+            // Maps a ring that the daemon already created and claims a lane. One TriggerRing per producing thread
+            explicit TriggerRing(const std::string &name);
+
+            // Creates a fresh ring, replacing any stale one, and unlinks it again on destruction
+            TriggerRing(create_t, const std::string &name);
+
+            ~TriggerRing();
+
+            TriggerRing(const TriggerRing &)            = delete;
+            TriggerRing &operator=(const TriggerRing &) = delete;
+
+            // Client only. False when this client's lane is full or the ring is closed
+            bool push(const TriggerCommand &command);
+
+            // True once the daemon behind this ring has shut down or been replaced. A closed ring never opens again
+            bool closed() const;
+
+            // Daemon only. False when the ring is empty
+            bool pop(TriggerCommand &command);
+
+            // Daemon only. Sleeps until a client pushes or the doorbell rings, and returns straight away once running is false
+            void park(const std::atomic<bool> &running);
+
+            // Wakes a parked daemon. Async-signal-safe
+            void ring_doorbell();
+
+        private:
+            static void close_stale(const std::string &name);
+
+            bool claim_lane();
+            bool any_pending() const;
+
+        private:
+            RingMemory *m_memory = nullptr;
+            std::string m_name;
+            bool        m_owner    = false;
+            int         m_lane     = -1;
+            uint32_t    m_nextLane = 0;
+    };
+
+    /**
+     * @brief Spin, then yield, then sleep, then park. Keeps the consumer a few hundred nanoseconds away from a trigger while busy without burning a core while idle
+     *
+     * The short sleeps cover bursts with small gaps, after about SLEEP_ROUNDS of them the ring is parked and the thread stops waking up at all
+     */
+    class IdleBackoff
+    {
+        public:
+            explicit IdleBackoff(uint32_t sleepMicros = 100);
+
+            void reset();
+            void wait(TriggerRing &ring, const std::atomic<bool> &running);
+
+        private:
+            uint32_t m_sleepMicros;
+            uint32_t m_firstRound;
+            uint32_t m_idleRounds;
+
+            static constexpr uint32_t SPIN_ROUNDS  = 4096;
+            static constexpr uint32_t YIELD_ROUNDS = SPIN_ROUNDS + 1024;
+            static constexpr uint32_t SLEEP_ROUNDS = YIELD_ROUNDS + 100;
+    };
+} // namespace Soundhouse::IPC
@@ -0,0 +1,825 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "library.hpp"
+
+namespace Soundhouse::Library
+{
+    namespace
+    {
+        // Version 2 added "!" lines for unreadable files, version 1 indexes still load fine
+        constexpr const char *INDEX_HEADER    = "SOUNDHOUSE-INDEX 2";
+        constexpr const char *INDEX_HEADER_V1 = "SOUNDHOUSE-INDEX 1";
+
+        void tokenize(const std::string &text, std::vector<std::string> &tokens)
+        {
+            std::string token;
+
+            for (char c : text)
+            {
+                if (std::isalnum(static_cast<unsigned char>(c)))
+                {
+                    token += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                }
+                else if (!token.empty())
+                {
+                    tokens.push_back(std::move(token));
+                    token.clear();
+                }
+            }
+
+            if (!token.empty())
+            {
+                tokens.push_back(std::move(token));
+            }
+        }
+
+        bool is_wav(const std::filesystem::path &path)
+        {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+            return extension == ".wav";
+        }
+
+        bool is_under(const std::string &path, const std::string &directory)
+        {
+            return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 && path[directory.size()] == '/';
+        }
+
+        // Index lines are tab separated, so tabs, newlines and backslashes in paths and tags get escaped
+        std::string escape(const std::string &text)
+        {
+            std::string out;
+            out.reserve(text.size());
+
+            for (char c : text)
+            {
+                switch (c)
+                {
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    default:
+                        out += c;
+                        break;
+                }
+            }
+
+            return out;
+        }
+
+        std::string unescape(const std::string &text)
+        {
+            std::string out;
+            out.reserve(text.size());
+
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                if (text[i] != '\\' || i + 1 == text.size())
+                {
+                    out += text[i];
+                    continue;
+                }
+
+                char next = text[++i];
+                out += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+            }
+
+            return out;
+        }
+
+        std::vector<std::string> split_fields(const std::string &line)
+        {
+            std::vector<std::string> fields;
+            std::size_t              start = 0;
+
+            for (;;)
+            {
+                std::size_t tab = line.find('\t', start);
+                fields.push_back(unescape(line.substr(start, tab - start)));
+
+                if (tab == std::string::npos)
+                {
+                    return fields;
+                }
+
+                start = tab + 1;
+            }
+        }
+    } // namespace
+
+    std::string default_index_path()
+    {
+        const char *cache = std::getenv("XDG_CACHE_HOME");
+        const char *home  = std::getenv("HOME");
+
+        std::filesystem::path directory;
+        if (cache != nullptr && *cache != '\0')
+        {
+            directory = std::filesystem::path(cache) / "soundhouse";
+        }
+        else if (home != nullptr && *home != '\0')
+        {
+            directory = std::filesystem::path(home) / ".cache" / "soundhouse";
+        }
+
+        std::error_code error;
+        if (!directory.empty())
+        {
+            std::filesystem::create_directories(directory, error);
+        }
+
+        return (directory / "library.index").string();
+    }
+
+    SoundLibrary::SoundLibrary(std::string indexPath) : m_indexPath(std::move(indexPath)), logger("SoundLibrary", Logging::LoggerLevel::Info, Logging::LoggerTimeResolution::Milliseconds)
+    {
+    }
+
+    SoundLibrary::~SoundLibrary()
+    {
+        stop_watching();
+
+        if (m_dirty)
+        {
+            save_index();
+        }
+    }
+
+    void SoundLibrary::add_root(const std::string &root)
+    {
+        std::string normalized = std::filesystem::absolute(root).lexically_normal().string();
+        if (normalized.size() > 1 && normalized.back() == '/')
+        {
+            normalized.pop_back();
+        }
+
+        if (std::find(m_roots.begin(), m_roots.end(), normalized) == m_roots.end())
+        {
+            m_roots.push_back(normalized);
+        }
+    }
+
+    bool SoundLibrary::load_index()
+    {
+        std::ifstream in(m_indexPath);
+        if (!in)
+        {
+            logger.info("No index at %s, starting cold", m_indexPath.c_str());
+            return false;
+        }
+
+        std::string line;
+        if (!std::getline(in, line) || (line != INDEX_HEADER && line != INDEX_HEADER_V1))
+        {
+            logger.warn("Ignoring index %s, unknown format", m_indexPath.c_str());
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+        while (std::getline(in, line))
+        {
+            // path, mtime, size, format, channels, rate, bits, data bytes, then any number of tags
+            std::vector<std::string> fields = split_fields(line);
+
+            // ! path, mtime, size for files that aren't WAVs we can read
+            if (fields.size() == 4 && fields[0] == "!")
+            {
+                m_unreadable[fields[1]] = FileStamp{std::strtoll(fields[2].c_str(), nullptr, 10), std::strtoull(fields[3].c_str(), nullptr, 10)};
+                continue;
+            }
+
+            if (fields.size() < 8 || fields[0].empty())
+            {
+                continue;
+            }
+
+            LibraryEntry entry;
+            entry.path               = fields[0];
+            entry.name               = std::filesystem::path(entry.path).stem().string();
+            entry.mtime              = std::strtoll(fields[1].c_str(), nullptr, 10);
+            entry.size               = std::strtoull(fields[2].c_str(), nullptr, 10);
+            entry.info.format        = static_cast<uint16_t>(std::strtoul(fields[3].c_str(), nullptr, 10));
+            entry.info.channels      = static_cast<uint16_t>(std::strtoul(fields[4].c_str(), nullptr, 10));
+            entry.info.sampleRate    = static_cast<uint32_t>(std::strtoul(fields[5].c_str(), nullptr, 10));
+            entry.info.bitsPerSample = static_cast<uint16_t>(std::strtoul(fields[6].c_str(), nullptr, 10));
+            entry.info.dataBytes     = std::strtoull(fields[7].c_str(), nullptr, 10);
+            entry.tags.assign(fields.begin() + 8, fields.end());
+
+            upsert(std::move(entry));
+        }
+
+        m_dirty = false;
+
+        logger.info("Loaded %zu entries from %s", m_byPath.size(), m_indexPath.c_str());
+        return true;
+    }
+
+    bool SoundLibrary::save_index()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+        // Write next to the real index and rename over it, so a crash never leaves half an index behind
+        std::string   temporary = m_indexPath + ".tmp";
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out)
+        {
+            logger.error("Failed to write index %s", temporary.c_str());
+            return false;
+        }
+
+        out << INDEX_HEADER << '\n';
+
+        for (const LibraryEntry &entry : m_entries)
+        {
+            if (entry.path.empty())
+            {
+                continue;
+            }
+
+            out << escape(entry.path) << '\t' << entry.mtime << '\t' << entry.size << '\t' << entry.info.format << '\t' << entry.info.channels << '\t' << entry.info.sampleRate << '\t'
+                << entry.info.bitsPerSample << '\t' << entry.info.dataBytes;
+
+            for (const std::string &tag : entry.tags)
+            {
+                out << '\t' << escape(tag);
+            }
+
+            out << '\n';
+        }
+
+        for (const auto &[path, stamp] : m_unreadable)
+        {
+            out << "!\t" << escape(path) << '\t' << stamp.mtime << '\t' << stamp.size << '\n';
+        }
+
+        out.close();
+
+        std::error_code error;
+        std::filesystem::rename(temporary, m_indexPath, error);
+        if (!out || error)
+        {
+            logger.error("Failed to save index %s", m_indexPath.c_str());
+            return false;
+        }
+
+        m_dirty = false;
+        return true;
+    }
+
+    void SoundLibrary::scan()
+    {
+        std::vector<std::pair<std::string, std::string>> trees;
+        for (const std::string &root : m_roots)
+        {
+            trees.emplace_back(root, root);
+        }
+
+        scan_trees(trees);
+    }
+
+    void SoundLibrary::scan_trees(const std::vector<std::pair<std::string, std::string>> &trees)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        // Directories are handed out one at a time, so a deep tree spreads over every worker instead of one per root
+        std::mutex                                       queueMutex;
+        std::condition_variable                          queueReady;
+        std::deque<std::pair<std::string, std::string>> pending(trees.begin(), trees.end());
+        std::size_t                                      busy = 0;
+
+        struct Results
+        {
+            std::vector<LibraryEntry>                      changed;
+            std::vector<std::pair<std::string, FileStamp>> unreadable;
+            std::vector<std::string>                       seen;
+        };
+
+        unsigned int         workerCount = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<Results> results(workerCount);
+
+        auto worker = [&](Results &out)
+        {
+            for (;;)
+            {
+                std::pair<std::string, std::string> job;
+                {
+                    std::unique_lock<std::mutex> lock(queueMutex);
+                    queueReady.wait(lock, [&] { return !pending.empty() || busy == 0; });
+
+                    if (pending.empty())
+                    {
+                        return;
+                    }
+
+                    job = std::move(pending.front());
+                    pending.pop_front();
+                    busy++;
+                }
+
+                const auto &[root, directory] = job;
+                std::vector<std::string> subdirectories;
+
+                std::error_code error;
+                for (std::filesystem::directory_iterator it(directory, std::filesystem::directory_options::skip_permission_denied, error), end; !error && it != end; it.increment(error))
+                {
+                    const std::filesystem::directory_entry &file = *it;
+
+                    // Symlinked folders could loop back on themselves
+                    if (file.is_directory(error) && !file.is_symlink(error))
+                    {
+                        subdirectories.push_back(file.path().string());
+                        continue;
+                    }
+
+                    if (!file.is_regular_file(error) || !is_wav(file.path()))
+                    {
+                        continue;
+                    }
+
+                    LibraryEntry entry;
+                    entry.path  = file.path().string();
+                    entry.size  = file.file_size(error);
+                    entry.mtime = static_cast<int64_t>(file.last_write_time(error).time_since_epoch().count());
+
+                    if (error)
+                    {
+                        error.clear();
+                        continue;
+                    }
+
+                    out.seen.push_back(entry.path);
+
+                    {
+                        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+                        auto known = m_byPath.find(entry.path);
+                        if (known != m_byPath.end() && m_entries[known->second].mtime == entry.mtime && m_entries[known->second].size == entry.size)
+                        {
+                            continue;
+                        }
+
+                        auto broken = m_unreadable.find(entry.path);
+                        if (broken != m_unreadable.end() && broken->second.mtime == entry.mtime && broken->second.size == entry.size)
+                        {
+                            continue;
+                        }
+                    }
+
+                    if (probe(root, entry.path, entry))
+                    {
+                        out.changed.push_back(std::move(entry));
+                    }
+                    else
+                    {
+                        out.unreadable.emplace_back(entry.path, FileStamp{entry.mtime, entry.size});
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (std::string &subdirectory : subdirectories)
+                {
+                    pending.emplace_back(root, std::move(subdirectory));
+                }
+
+                busy--;
+                queueReady.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < workerCount; i++)
+        {
+            workers.emplace_back(worker, std::ref(results[i]));
+        }
+
+        worker(results[0]);
+
+        for (std::thread &thread : workers)
+        {
+            thread.join();
+        }
+
+        std::unordered_set<std::string> seen;
+        std::size_t                     changed = 0;
+        std::size_t                     removed = 0;
+
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+        for (Results &result : results)
+        {
+            seen.insert(std::make_move_iterator(result.seen.begin()), std::make_move_iterator(result.seen.end()));
+
+            for (LibraryEntry &entry : result.changed)
+            {
+                upsert(std::move(entry));
+                changed++;
+            }
+
+            for (const auto &[path, stamp] : result.unreadable)
+            {
+                mark_unreadable(path, stamp);
+                changed++;
+            }
+        }
+
+        auto vanished = [&](const std::string &path)
+        {
+            bool scanned = std::any_of(trees.begin(), trees.end(), [&](const auto &tree) { return is_under(path, tree.second); });
+            return scanned && seen.count(path) == 0;
+        };
+
+        std::vector<std::string> gone;
+        for (const auto &[path, id] : m_byPath)
+        {
+            if (vanished(path))
+            {
+                gone.push_back(path);
+            }
+        }
+
+        for (const auto &[path, stamp] : m_unreadable)
+        {
+            if (vanished(path))
+            {
+                gone.push_back(path);
+            }
+        }
+
+        for (const std::string &path : gone)
+        {
+            remove(path);
+            removed++;
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        logger.info("Scanned %zu files in %lld ms (%zu changed, %zu removed)", seen.size(), static_cast<long long>(elapsed), changed, removed);
+    }
+
+    bool SoundLibrary::probe(const std::string &root, const std::string &path, LibraryEntry &entry)
+    {
+        if (!read_wav_header(path, entry.info))
+        {
+            logger.debug("Skipping %s, not a readable WAV", path.c_str());
+            return false;
+        }
+
+        std::filesystem::path file(path);
+        entry.name = file.stem().string();
+
+        // Default tags are the folders between the root and the file, e.g. <root>/memes/horns/clown.wav -> memes, horns
+        std::filesystem::path folders = file.parent_path().lexically_relative(root);
+        for (const std::filesystem::path &folder : folders)
+        {
+            if (!folder.empty() && folder != ".")
+            {
+                entry.tags.push_back(folder.string());
+            }
+        }
+
+        return true;
+    }
+
+    void SoundLibrary::upsert(LibraryEntry entry)
+    {
+        m_unreadable.erase(entry.path);
+
+        auto known = m_byPath.find(entry.path);
+        if (known != m_byPath.end())
+        {
+            EntryID id = known->second;
+
+            // Tags may have been edited by the user, a content change shouldn't throw them away
+            entry.tags = std::move(m_entries[id].tags);
+
+            unindex_tokens(id);
+            m_entries[id] = std::move(entry);
+            index_tokens(id);
+        }
+        else
+        {
+            EntryID id;
+            if (!m_free.empty())
+            {
+                id = m_free.back();
+                m_free.pop_back();
+                m_entries[id] = std::move(entry);
+            }
+            else
+            {
+                id = static_cast<EntryID>(m_entries.size());
+                m_entries.push_back(std::move(entry));
+            }
+
+            m_byPath[m_entries[id].path] = id;
+            index_tokens(id);
+        }
+
+        m_dirty = true;
+    }
+
+    void SoundLibrary::mark_unreadable(const std::string &path, FileStamp stamp)
+    {
+        // A file that used to parse and got broken drops out of search
+        remove(path);
+
+        m_unreadable[path] = stamp;
+        m_dirty            = true;
+    }
+
+    void SoundLibrary::remove(const std::string &path)
+    {
+        if (m_unreadable.erase(path) > 0)
+        {
+            m_dirty = true;
+        }
+
+        auto known = m_byPath.find(path);
+        if (known == m_byPath.end())
+        {
+            return;
+        }
+
+        EntryID id = known->second;
+
+        unindex_tokens(id);
+        m_byPath.erase(known);
+
+        m_entries[id] = LibraryEntry{};
+        m_free.push_back(id);
+
+        m_dirty = true;
+    }
+
+    void SoundLibrary::remove_tree(const std::string &directory)
+    {
+        std::vector<std::string> gone;
+        for (const auto &[path, id] : m_byPath)
+        {
+            if (is_under(path, directory))
+            {
+                gone.push_back(path);
+            }
+        }
+
+        for (const auto &[path, stamp] : m_unreadable)
+        {
+            if (is_under(path, directory))
+            {
+                gone.push_back(path);
+            }
+        }
+
+        for (const std::string &path : gone)
+        {
+            remove(path);
+        }
+    }
+
+    void SoundLibrary::index_tokens(EntryID id)
+    {
+        const LibraryEntry &entry = m_entries[id];
+
+        std::vector<std::string> tokens;
+        tokenize(entry.name, tokens);
+        for (const std::string &tag : entry.tags)
+        {
+            tokenize(tag, tokens);
+        }
+
+        for (const std::string &token : tokens)
+        {
+            m_tokens[token].insert(id);
+        }
+    }
+
+    void SoundLibrary::unindex_tokens(EntryID id)
+    {
+        const LibraryEntry &entry = m_entries[id];
+
+        std::vector<std::string> tokens;
+        tokenize(entry.name, tokens);
+        for (const std::string &tag : entry.tags)
+        {
+            tokenize(tag, tokens);
+        }
+
+        for (const std::string &token : tokens)
+        {
+            auto it = m_tokens.find(token);
+            if (it == m_tokens.end())
+            {
+                continue;
+            }
+
+            it->second.erase(id);
+            if (it->second.empty())
+            {
+                m_tokens.erase(it);
+            }
+        }
+    }
+
+    void SoundLibrary::set_tags(const std::string &path, const std::vector<std::string> &tags)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+        auto known = m_byPath.find(path);
+        if (known == m_byPath.end())
+        {
+            return;
+        }
+
+        unindex_tokens(known->second);
+        m_entries[known->second].tags = tags;
+        index_tokens(known->second);
+
+        m_dirty = true;
+    }
+
+    std::vector<LibraryEntry> SoundLibrary::search(const std::string &query, std::size_t limit) const
+    {
+        std::vector<std::string> terms;
+        tokenize(query, terms);
+
+        std::vector<LibraryEntry> found;
+
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+        if (terms.empty())
+        {
+            for (const LibraryEntry &entry : m_entries)
+            {
+                if (found.size() == limit)
+                {
+                    break;
+                }
+
+                if (!entry.path.empty())
+                {
+                    found.push_back(entry);
+                }
+            }
+
+            return found;
+        }
+
+        std::unordered_set<EntryID> matches;
+
+        for (std::size_t i = 0; i < terms.size(); i++)
+        {
+            std::unordered_set<EntryID> termMatches;
+
+            for (auto it = m_tokens.lower_bound(terms[i]); it != m_tokens.end() && it->first.compare(0, terms[i].size(), terms[i]) == 0; ++it)
+            {
+                termMatches.insert(it->second.begin(), it->second.end());
+            }
+
+            if (i == 0)
+            {
+                matches = std::move(termMatches);
+            }
+            else
+            {
+                for (auto it = matches.begin(); it != matches.end();)
+                {
+                    it = termMatches.count(*it) ? std::next(it) : matches.erase(it);
+                }
+            }
+
+            if (matches.empty())
+            {
+                return found;
+            }
+        }
+
+        // Order ids rather than entries, so only the ones that make the cut get copied out
+        std::vector<EntryID> ids(matches.begin(), matches.end());
+        std::size_t          kept = std::min(limit, ids.size());
+
+        std::partial_sort(ids.begin(), ids.begin() + kept, ids.end(), [this](EntryID a, EntryID b) { return m_entries[a].name < m_entries[b].name; });
+
+        found.reserve(kept);
+        for (std::size_t i = 0; i < kept; i++)
+        {
+            found.push_back(m_entries[ids[i]]);
+        }
+
+        return found;
+    }
+
+    std::size_t SoundLibrary::size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_byPath.size();
+    }
+
+    void SoundLibrary::watch()
+    {
+        if (m_watcher)
+        {
+            return;
+        }
+
+        m_watcher = std::make_unique<Watching::FileWatcher>([this](Watching::WatchEvent event, const std::string &path) { on_watch_event(event, path); }, "LibraryWatcher");
+
+        for (const std::string &root : m_roots)
+        {
+            m_watcher->watch_tree(root);
+        }
+
+        m_watcher->start();
+    }
+
+    void SoundLibrary::stop_watching()
+    {
+        m_watcher.reset();
+    }
+
+    void SoundLibrary::on_watch_event(Watching::WatchEvent event, const std::string &path)
+    {
+        switch (event)
+        {
+            case Watching::WatchEvent::Changed:
+            {
+                if (!is_wav(path))
+                {
+                    return;
+                }
+
+                std::error_code       error;
+                std::filesystem::path file(path);
+
+                LibraryEntry entry;
+                entry.path  = path;
+                entry.size  = std::filesystem::file_size(file, error);
+                entry.mtime = static_cast<int64_t>(std::filesystem::last_write_time(file, error).time_since_epoch().count());
+
+                if (error)
+                {
+                    return;
+                }
+
+                bool readable = probe(root_for(path), path, entry);
+
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                if (readable)
+                {
+                    upsert(std::move(entry));
+                }
+                else
+                {
+                    mark_unreadable(path, FileStamp{entry.mtime, entry.size});
+                }
+                break;
+            }
+
+            case Watching::WatchEvent::Removed:
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                remove(path);
+                remove_tree(path);
+                break;
+            }
+
+            case Watching::WatchEvent::DirectoryCreated:
+                scan_trees({{root_for(path), path}});
+                break;
+
+            case Watching::WatchEvent::Overflow:
+                scan();
+                break;
+        }
+    }
+
+    std::string SoundLibrary::root_for(const std::string &path) const
+    {
+        std::string best;
+        for (const std::string &root : m_roots)
+        {
+            if (is_under(path, root) && root.size() > best.size())
+            {
+                best = root;
+            }
+        }
+
+        return best;
+    }
+} // namespace Soundhouse::Library
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "builtin/logger.hpp"
+#include "builtin/watcher.hpp"
+#include "wav.hpp"
+
+namespace Soundhouse::Library
+{
+    // $XDG_CACHE_HOME/soundhouse/library.index, falling back to ~/.cache. The folder is created if it's missing
+    std::string default_index_path();
+
+    /**
+     * @brief One indexed clip. Tags default to the folders between the library root and the file
+     *
+     */
+    struct LibraryEntry
+    {
+        std::string path;
+        std::string name;
+
+        int64_t  mtime = 0;
+        uint64_t size  = 0;
+
+        WavInfo info;
+
+        std::vector<std::string> tags;
+    };
+
+    /**
+     * @brief Indexes every WAV under a set of root folders, keeps the result on disk and follows changes through inotify
+     *
+     * A warm start loads the index, stats the tree in parallel and only parses headers of files whose mtime or size moved
+     */
+    class SoundLibrary
+    {
+        public:
+            explicit SoundLibrary(std::string indexPath);
+            ~SoundLibrary();
+
+            SoundLibrary(const SoundLibrary &)            = delete;
+            SoundLibrary &operator=(const SoundLibrary &) = delete;
+
+            void add_root(const std::string &root);
+
+            bool load_index();
+            bool save_index();
+
+            void scan();
+
+            void watch();
+            void stop_watching();
+
+            void set_tags(const std::string &path, const std::vector<std::string> &tags);
+
+            // Every whitespace separated term has to prefix-match a word of the name or a tag
+            std::vector<LibraryEntry> search(const std::string &query, std::size_t limit = 100) const;
+
+            std::size_t size() const;
+
+        private:
+            using EntryID = uint32_t;
+
+            struct FileStamp
+            {
+                int64_t  mtime = 0;
+                uint64_t size  = 0;
+            };
+
+            void scan_trees(const std::vector<std::pair<std::string, std::string>> &trees);
+
+            bool probe(const std::string &root, const std::string &path, LibraryEntry &entry);
+
+            // These expect m_mutex to be held exclusively
+            void upsert(LibraryEntry entry);
+            void mark_unreadable(const std::string &path, FileStamp stamp);
+            void remove(const std::string &path);
+            void remove_tree(const std::string &directory);
+
+            void index_tokens(EntryID id);
+            void unindex_tokens(EntryID id);
+
+            void on_watch_event(Watching::WatchEvent event, const std::string &path);
+
+            std::string root_for(const std::string &path) const;
+
+        private:
+            std::string     m_indexPath;
+            Logging::Logger logger;
+
+            std::vector<std::string> m_roots;
+
+            mutable std::shared_mutex m_mutex;
+
+            // Removed entries leave a hole with an empty path that the next insert reuses, so token sets can hold plain ids
+            std::vector<LibraryEntry>                m_entries;
+            std::vector<EntryID>                     m_free;
+            std::unordered_map<std::string, EntryID> m_byPath;
+
+            // .wav files that failed to parse, remembered so an unchanged broken file isn't reopened on every scan
+            std::unordered_map<std::string, FileStamp> m_unreadable;
+
+            // Sorted so a prefix lookup is a lower_bound and a short walk
+            std::map<std::string, std::unordered_set<EntryID>> m_tokens;
+
+            bool m_dirty = false;
+
+            std::unique_ptr<Watching::FileWatcher> m_watcher;
+    };
+} // namespace Soundhouse::Library
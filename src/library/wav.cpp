@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstring>
+
+#include "wav.hpp"
+
+namespace Soundhouse::Library
+{
+    namespace
+    {
+        constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+        uint16_t read_u16(const unsigned char *bytes)
+        {
+            return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+        }
+
+        uint32_t read_u32(const unsigned char *bytes)
+        {
+            return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        }
+    } // namespace
+
+    double WavInfo::duration() const
+    {
+        uint64_t frameBytes = static_cast<uint64_t>(channels) * ((bitsPerSample + 7) / 8);
+        if (frameBytes == 0 || sampleRate == 0)
+        {
+            return 0.0;
+        }
+
+        return static_cast<double>(dataBytes / frameBytes) / sampleRate;
+    }
+
+    bool read_wav_header(const std::string &path, WavInfo &info)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        unsigned char riff[12];
+        if (std::fread(riff, 1, sizeof(riff), file) != sizeof(riff) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            std::fclose(file);
+            return false;
+        }
+
+        bool haveFormat = false;
+        bool haveData   = false;
+
+        unsigned char chunk[8];
+        while (!(haveFormat && haveData) && std::fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk))
+        {
+            uint32_t size      = read_u32(chunk + 4);
+            uint32_t remaining = size;
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                // 16 bytes of PCM fields, plus the sub-format GUID at offset 24 for WAVE_FORMAT_EXTENSIBLE
+                unsigned char fmt[40] = {};
+                uint32_t      wanted  = size < sizeof(fmt) ? size : sizeof(fmt);
+
+                if (std::fread(fmt, 1, wanted, file) != wanted)
+                {
+                    break;
+                }
+
+                info.format        = read_u16(fmt);
+                info.channels      = read_u16(fmt + 2);
+                info.sampleRate    = read_u32(fmt + 4);
+                info.bitsPerSample = read_u16(fmt + 14);
+
+                if (info.format == WAVE_FORMAT_EXTENSIBLE && wanted >= 26)
+                {
+                    info.format = read_u16(fmt + 24);
+                }
+
+                haveFormat = true;
+                remaining -= wanted;
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0)
+            {
+                info.dataBytes = size;
+                haveData       = true;
+            }
+
+            // Chunks are padded to an even length
+            long skip = static_cast<long>(remaining) + (size & 1);
+            if (!(haveFormat && haveData) && skip > 0 && std::fseek(file, skip, SEEK_CUR) != 0)
+            {
+                break;
+            }
+        }
+
+        std::fclose(file);
+        return haveFormat && haveData;
+    }
+} // namespace Soundhouse::Library
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Soundhouse::Library
+{
+    /**
+     * @brief What we know about a WAV file without touching its samples
+     *
+     */
+    struct WavInfo
+    {
+        uint16_t format        = 0; // WAVE_FORMAT_* tag, resolved through WAVE_FORMAT_EXTENSIBLE
+        uint16_t channels      = 0;
+        uint32_t sampleRate    = 0;
+        uint16_t bitsPerSample = 0;
+        uint64_t dataBytes     = 0;
+
+        double duration() const;
+    };
+
+    /**
+     * @brief Reads the RIFF/fmt/data headers of a WAV file. Chunks are skipped with seeks, the sample data is never read
+     *
+     * @return false if the file can't be opened or isn't a WAV we understand
+     */
+    bool read_wav_header(const std::string &path, WavInfo &info);
+} // namespace Soundhouse::Library
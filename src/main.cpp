@@ -2,11 +2,22 @@
 #include "builtin/logger.hpp"
 #include "builtin/sound.hpp"
 #include "builtin/manager.hpp"
+#include "library/library.hpp"
+#include "ui/soundboard.hpp"
 
+#ifndef _WIN32
+#include "ipc/daemon.hpp"
+
+#include <csignal>
+#endif
+
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 class TestingBackend : public Soundhouse::Sounds::Backends::IAudioBackend
 {
@@ -36,6 +47,12 @@ class TestingBackend : public Soundhouse::Sounds::Backends::IAudioBackend
             logger.info("Unloaded sound: %i", id);
         }
 
+        bool reload_sound(int id, const std::string &path) override
+        {
+            logger.info("Reloaded sound %i from %s", id, path.c_str());
+            return std::filesystem::exists(path);
+        }
+
         void play(int id) override
         {
             logger.info("Playing sound: %i", id);
@@ -51,20 +68,114 @@ class TestingBackend : public Soundhouse::Sounds::Backends::IAudioBackend
             logger.info("Increased voume of sound %i to %f", id, volume);
         }
 
+        float level(int id) override
+        {
+            return 0.0f;
+        }
+
+        bool any_playing() const override
+        {
+            return false;
+        }
+
     private:
         int nextID = 0;
 };
 
-int main()
+#ifndef _WIN32
+static Soundhouse::IPC::TriggerDaemon *g_daemon = nullptr;
+
+static void stop_daemon(int)
+{
+    if (g_daemon != nullptr)
+    {
+        g_daemon->stop();
+    }
+}
+#endif
+
+int main(int argc, char **argv)
 {
+    bool daemonMode = false;
+    bool watchMode  = false;
+
+    std::vector<std::string> libraryRoots;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--library") == 0 && i + 1 < argc)
+        {
+            libraryRoots.push_back(argv[++i]);
+            continue;
+        }
+
+        if (std::strcmp(argv[i], "--daemon") == 0)
+        {
+            daemonMode = true;
+        }
+        else if (std::strcmp(argv[i], "--watch") == 0)
+        {
+            watchMode = true;
+        }
+    }
+
     auto backend = std::make_unique<Soundhouse::Sounds::Backends::SDL2Backend>("SDL2Backend");
     Soundhouse::Sounds::SoundManager manager(std::move(backend));
 
-    auto fart = manager.get_builtin(Soundhouse::Sounds::BuiltinSound::Fart);
+    // Picks up edits to loaded clips without unloading them, handy while making sounds
+    if (watchMode)
+    {
+        manager.watch();
+    }
+
+#ifndef _WIN32
+    // Headless mode for stream decks, MIDI bridges and scripts, see ipc/daemon.hpp and soundhouse-ctl
+    if (daemonMode)
+    {
+        Soundhouse::IPC::TriggerDaemon daemon(manager);
+
+        g_daemon = &daemon;
+        std::signal(SIGINT, stop_daemon);
+        std::signal(SIGTERM, stop_daemon);
+
+        daemon.run();
+
+        g_daemon = nullptr;
+        return 0;
+    }
+#endif
+
+    // Folders of clips to browse from the soundboard's search box. The index is kept between runs, so a warm start only re-reads what changed
+    std::unique_ptr<Soundhouse::Library::SoundLibrary> library;
+    if (!libraryRoots.empty())
+    {
+        library = std::make_unique<Soundhouse::Library::SoundLibrary>(Soundhouse::Library::default_index_path());
+
+        for (const std::string &root : libraryRoots)
+        {
+            library->add_root(root);
+        }
+
+        library->load_index();
+        library->scan();
+        library->save_index();
+        library->watch();
+    }
+
+    Soundhouse::UI::SoundboardView board(manager);
+
+    if (library)
+    {
+        board.set_library(*library);
+    }
+
+    board.add_pad("Fart", manager.get_builtin(Soundhouse::Sounds::BuiltinSound::Fart));
+    board.add_pad("Menu Click", manager.get_builtin(Soundhouse::Sounds::BuiltinSound::MenuClick));
+    board.add_pad("Menu Hover", manager.get_builtin(Soundhouse::Sounds::BuiltinSound::MenuHover));
+    board.add_pad("Error Beep", manager.get_builtin(Soundhouse::Sounds::BuiltinSound::ErrorBeep));
+    board.add_pad("Clown Horn", manager.get_builtin(Soundhouse::Sounds::BuiltinSound::ClownHorn));
 
-    manager.play(fart);
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    manager.stop(fart);
+    board.run();
 
     return 0;
 }
\ No newline at end of file
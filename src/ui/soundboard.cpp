@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <imgui.h>
+#include <backends/imgui_impl_glfw.h>
+#include <backends/imgui_impl_opengl3.h>
+
+#include "soundboard.hpp"
+
+namespace Soundhouse::UI
+{
+    SoundboardView::SoundboardView(Sounds::SoundManager &manager, SoundboardConfig config)
+        : m_manager(manager), m_config(config), logger("Soundboard", Logging::LoggerLevel::Info, Logging::LoggerTimeResolution::Milliseconds)
+    {
+        if (!glfwInit())
+        {
+            logger.critical("Failed to initialize GLFW");
+            throw std::runtime_error("glfwInit failed");
+        }
+
+        // GL 3.0 + GLSL 130 is the lowest common denominator, which keeps Mesa's llvmpipe (LIBGL_ALWAYS_SOFTWARE=1) happy
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+
+        m_window = glfwCreateWindow(m_config.width, m_config.height, m_config.title, nullptr, nullptr);
+        if (m_window == nullptr)
+        {
+            logger.critical("Failed to create window");
+            glfwTerminate();
+            throw std::runtime_error("glfwCreateWindow failed");
+        }
+
+        glfwMakeContextCurrent(m_window);
+
+        // Pacing is done in wait_for_next_frame, vsync would only add a second blocking point
+        glfwSwapInterval(0);
+
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        {
+            logger.critical("Failed to load OpenGL functions");
+            glfwDestroyWindow(m_window);
+            glfwTerminate();
+            throw std::runtime_error("gladLoadGLLoader failed");
+        }
+
+        logger.info("OpenGL renderer: %s", reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGui::StyleColorsDark();
+
+        ImGui_ImplGlfw_InitForOpenGL(m_window, true);
+        ImGui_ImplOpenGL3_Init("#version 130");
+    }
+
+    SoundboardView::~SoundboardView()
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+    }
+
+    std::size_t SoundboardView::add_pad(const std::string &label, Sounds::Sound sound)
+    {
+        m_pads.push_back(Pad{label, sound});
+
+        return m_pads.size() - 1;
+    }
+
+    void SoundboardView::set_library(Library::SoundLibrary &library)
+    {
+        m_library = &library;
+    }
+
+    void SoundboardView::run()
+    {
+        m_lastFrame   = std::chrono::steady_clock::now();
+        m_extraFrames = 1;
+
+        bool animating = false;
+
+        while (!glfwWindowShouldClose(m_window))
+        {
+            wait_for_next_frame(animating);
+
+            if (glfwGetWindowAttrib(m_window, GLFW_ICONIFIED))
+            {
+                animating = false;
+                continue;
+            }
+
+            draw_frame();
+            animating = m_metersMoving || m_manager.any_playing();
+        }
+    }
+
+    void SoundboardView::wait_for_next_frame(bool animating)
+    {
+        using clock = std::chrono::steady_clock;
+
+        // Nothing is moving and ImGui has settled, so sleep until there's input
+        if (!animating && m_extraFrames == 0)
+        {
+            glfwWaitEvents();
+
+            // ImGui reacts to input one frame late (hover, release), so give it a second frame after every wake up
+            m_extraFrames = 2;
+        }
+
+        const auto period = std::chrono::duration<double>(1.0 / std::max(m_config.meterRefreshHz, 1.0f));
+
+        for (;;)
+        {
+            auto remaining = std::chrono::duration<double>(m_lastFrame + period - clock::now()).count();
+            if (remaining <= 0.0)
+            {
+                break;
+            }
+
+            glfwWaitEventsTimeout(remaining);
+        }
+
+        glfwPollEvents();
+
+        if (m_extraFrames > 0)
+        {
+            m_extraFrames--;
+        }
+
+        m_lastFrame = clock::now();
+    }
+
+    void SoundboardView::update_meter(Pad &pad)
+    {
+        pad.shownLevel = std::max(m_manager.level(pad.sound), pad.shownLevel * METER_DECAY);
+        if (pad.shownLevel <= METER_SILENCE)
+        {
+            pad.shownLevel = 0.0f;
+            return;
+        }
+
+        m_metersMoving = true;
+    }
+
+    void SoundboardView::draw_frame()
+    {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        // Set again by any visible meter that is still falling
+        m_metersMoving = false;
+
+        // Keep ImGui busy while a button is held, otherwise the press would freeze until the next event
+        if (ImGui::IsAnyItemActive())
+        {
+            m_extraFrames = std::max(m_extraFrames, 1);
+        }
+
+        const ImGuiViewport *viewport = ImGui::GetMainViewport();
+        ImGui::SetNextWindowPos(viewport->WorkPos);
+        ImGui::SetNextWindowSize(viewport->WorkSize);
+
+        ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoBringToFrontOnFocus;
+        if (ImGui::Begin("Soundboard", nullptr, flags))
+        {
+            if (m_library != nullptr)
+            {
+                draw_search();
+            }
+
+            // The grid scrolls on its own, so the clipper only ever sees the pads area
+            if (ImGui::BeginChild("Pads"))
+            {
+                draw_grid();
+            }
+            ImGui::EndChild();
+        }
+        ImGui::End();
+
+        ImGui::Render();
+
+        int width  = 0;
+        int height = 0;
+        glfwGetFramebufferSize(m_window, &width, &height);
+        glViewport(0, 0, width, height);
+        glClearColor(0.08f, 0.08f, 0.09f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        glfwSwapBuffers(m_window);
+    }
+
+    void SoundboardView::draw_search()
+    {
+        // Only searched when the text changes, never per frame
+        if (ImGui::InputTextWithHint("##search", "Search library", m_query, sizeof(m_query)))
+        {
+            m_results = m_query[0] != '\0' ? m_library->search(m_query, SEARCH_LIMIT) : std::vector<Library::LibraryEntry>();
+        }
+
+        for (std::size_t i = 0; i < m_results.size(); i++)
+        {
+            const Library::LibraryEntry &entry = m_results[i];
+
+            ImGui::PushID(static_cast<int>(i));
+
+            if (ImGui::Selectable(entry.name.c_str()))
+            {
+                Sounds::Sound sound = m_manager.load(entry.path);
+                if (sound.is_valid())
+                {
+                    add_pad(entry.name, sound);
+                }
+                else
+                {
+                    logger.warn("Failed to load %s", entry.path.c_str());
+                }
+            }
+
+            ImGui::SameLine();
+            ImGui::TextDisabled("%.1fs  %u Hz  %uch", entry.info.duration(), entry.info.sampleRate, static_cast<unsigned>(entry.info.channels));
+
+            ImGui::PopID();
+        }
+
+        ImGui::Separator();
+    }
+
+    void SoundboardView::draw_grid()
+    {
+        const ImGuiStyle &style = ImGui::GetStyle();
+
+        const float padSize   = m_config.padSize;
+        const float cellWidth = padSize + style.ItemSpacing.x;
+        const float rowHeight = padSize + style.ItemSpacing.y;
+
+        const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) / cellWidth));
+        const int count   = static_cast<int>(m_pads.size());
+        const int rows    = (count + columns - 1) / columns;
+
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+
+        // Rows outside the scroll region are skipped entirely, so a board of thousands of pads costs as much as one screen of them
+        ImGuiListClipper clipper;
+        clipper.Begin(rows, rowHeight);
+
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                for (int column = 0; column < columns; column++)
+                {
+                    int index = row * columns + column;
+                    if (index >= count)
+                    {
+                        break;
+                    }
+
+                    Pad &pad = m_pads[index];
+
+                    if (column > 0)
+                    {
+                        ImGui::SameLine();
+                    }
+
+                    ImGui::PushID(index);
+
+                    if (ImGui::Button(pad.label.c_str(), ImVec2(padSize, padSize)))
+                    {
+                        m_manager.play(pad.sound);
+                        m_extraFrames = std::max(m_extraFrames, static_cast<int>(std::ceil(PLAY_GRACE_SECONDS * m_config.meterRefreshHz)));
+                    }
+
+                    // Off-screen pads keep their old level and simply catch up once they scroll back in
+                    update_meter(pad);
+
+                    if (pad.shownLevel > 0.0f)
+                    {
+                        ImVec2 min = ImGui::GetItemRectMin();
+                        ImVec2 max = ImGui::GetItemRectMax();
+
+                        float level = std::min(pad.shownLevel, 1.0f);
+                        float top   = max.y - (max.y - min.y) * level;
+
+                        drawList->AddRectFilled(ImVec2(max.x - 6.0f, top), ImVec2(max.x - 2.0f, max.y), IM_COL32(90, 220, 120, 255));
+                    }
+
+                    ImGui::PopID();
+                }
+            }
+        }
+
+        clipper.End();
+    }
+} // namespace Soundhouse::UI
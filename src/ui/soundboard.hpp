@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "builtin/logger.hpp"
+#include "builtin/manager.hpp"
+#include "builtin/sound.hpp"
+#include "library/library.hpp"
+
+struct GLFWwindow;
+
+namespace Soundhouse::UI
+{
+    /**
+     * @brief Window and grid settings for the soundboard view
+     *
+     */
+    struct SoundboardConfig
+    {
+        const char *title  = "Soundhouse";
+        int         width  = 1280;
+        int         height = 720;
+
+        float padSize = 96.0f;
+
+        // Frames are never drawn faster than this, and only while a meter is moving
+        float meterRefreshHz = 30.0f;
+    };
+
+    /**
+     * @brief A single pad on the board. shownLevel is the decaying meter, fed from the backend's per-sound peak
+     *
+     */
+    struct Pad
+    {
+        std::string   label;
+        Sounds::Sound sound;
+
+        float shownLevel = 0.0f;
+    };
+
+    /**
+     * @brief ImGui soundboard. Only the visible rows of the pad grid are submitted, and the window sleeps in glfwWaitEvents while nothing is animating
+     *
+     * Meter levels are polled from the backend on the UI thread, so the audio side never has to wake the window up. Every
+     * play comes from a click on this thread, which is already awake and keeps drawing until the sound has gone quiet
+     */
+    class SoundboardView
+    {
+        public:
+            explicit SoundboardView(Sounds::SoundManager &manager, SoundboardConfig config = {});
+            ~SoundboardView();
+
+            SoundboardView(const SoundboardView &)            = delete;
+            SoundboardView &operator=(const SoundboardView &) = delete;
+
+            // Pads have to be added before run() or from the UI thread
+            std::size_t add_pad(const std::string &label, Sounds::Sound sound);
+
+            // Shows a search box over the library. Clicking a hit loads it and puts it on the board
+            void set_library(Library::SoundLibrary &library);
+
+            void run();
+
+        private:
+            void wait_for_next_frame(bool animating);
+
+            void update_meter(Pad &pad);
+
+            void draw_frame();
+            void draw_search();
+            void draw_grid();
+
+        private:
+            Sounds::SoundManager &m_manager;
+            SoundboardConfig      m_config;
+            Logging::Logger       logger;
+
+            GLFWwindow *m_window = nullptr;
+
+            std::vector<Pad> m_pads;
+
+            Library::SoundLibrary             *m_library    = nullptr;
+            char                               m_query[256] = {};
+            std::vector<Library::LibraryEntry> m_results;
+
+            std::chrono::steady_clock::time_point m_lastFrame;
+            int                                   m_extraFrames  = 0;
+            bool                                  m_metersMoving = false;
+
+            // A click is heard one audio block later, keep drawing long enough for the backend to report it
+            static constexpr float PLAY_GRACE_SECONDS = 0.25f;
+
+            static constexpr std::size_t SEARCH_LIMIT = 50;
+
+            static constexpr float METER_SILENCE = 0.001f;
+            static constexpr float METER_DECAY   = 0.85f;
+    };
+} // namespace Soundhouse::UI
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "ipc/client.hpp"
+
+namespace
+{
+    void usage()
+    {
+        std::fprintf(stderr, "usage: soundhouse-ctl <command> [argument]\n"
+                             "\n"
+                             "  play <id>      trigger a sound\n"
+                             "  stop <id>      stop a sound\n"
+                             "  load <path>    load a WAV and print its id\n"
+                             "  unload <id>    unload a sound\n"
+                             "  list           list loaded sounds\n");
+    }
+
+    // Same rules as the daemon: the whole argument has to be a non-negative number that fits a sound id
+    bool parse_id(const char *text, int &id)
+    {
+        char *end   = nullptr;
+        long  value = std::strtol(text, &end, 10);
+
+        if (*text == '\0' || *end != '\0' || value < 0 || value > INT32_MAX)
+        {
+            return false;
+        }
+
+        id = static_cast<int>(value);
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return 2;
+    }
+
+    std::string command  = argv[1];
+    const char *argument = argc > 2 ? argv[2] : nullptr;
+
+    // Checked before connecting, a typo shouldn't turn into a trigger for some other sound
+    int  id      = -1;
+    bool takesID = command == "play" || command == "stop" || command == "unload";
+    bool valid   = takesID ? argument != nullptr && parse_id(argument, id) : (command == "load" && argument != nullptr) || command == "list";
+    if (!valid)
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        Soundhouse::IPC::TriggerClient client;
+
+        bool ok = false;
+
+        if (command == "play")
+        {
+            ok = client.play(id);
+        }
+        else if (command == "stop")
+        {
+            ok = client.stop(id);
+        }
+        else if (command == "load")
+        {
+            int loaded = client.load(argument);
+            if (loaded >= 0)
+            {
+                std::printf("%d\n", loaded);
+                ok = true;
+            }
+        }
+        else if (command == "unload")
+        {
+            ok = client.unload(id);
+        }
+        else
+        {
+            std::vector<Soundhouse::IPC::SoundListing> sounds;
+
+            ok = client.list(sounds);
+            for (const auto &sound : sounds)
+            {
+                std::printf("%d\t%s\n", sound.id, sound.path.c_str());
+            }
+        }
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "soundhouse-ctl: %s\n", client.last_error().c_str());
+            return 1;
+        }
+    }
+    catch (const std::exception &error)
+    {
+        std::fprintf(stderr, "soundhouse-ctl: %s\n", error.what());
+        return 1;
+    }
+
+    return 0;
+}